@@ -0,0 +1,327 @@
+/*
+ * Kernel microbenchmark firmware (Cortex-M4, QEMU or hardware)
+ * ------------------------------------------------------------
+ * Measures the cost of the kernel hot paths in cycles:
+ *
+ *   task_create          creating a task (TCB + stack + initial frame)
+ *   select_next_task_*   task selection, once per sched_algo_t
+ *   unblock_tasks        delay list check with nothing due
+ *   systick_handler      the complete SysTick_Handler body
+ *   context_switch       one task handing the CPU to another (PendSV)
+ *   task_delay_1         task_delay(1) round trip, including the wait
+ *   tick_wake_latency    SysTick expiry until the woken task runs
+ *                        (always in SysTick counts, reported as timer=systick)
+ *
+ * Timing uses the DWT cycle counter. QEMU does not model the DWT, so if
+ * CYCCNT does not advance TIM2 is used as a free-running 32-bit counter
+ * instead (reported as timer=tim2). Results are written through ARM
+ * semihosting, one line per benchmark:
+ *
+ *   bench=<name> timer=<dwt|tim2> n=<samples> min=<c> avg=<c> max=<c>
+ *
+ * followed by "bench_done" and a semihosting exit.
+ *
+ * Run with the bench-qemu target, or:
+ *   qemu-system-arm -M netduinoplus2 -nographic -icount shift=0 \
+ *       -semihosting-config enable=on,target=native \
+ *       -kernel task-scheduler-bench.elf
+ *
+ * Semihosting needs QEMU or a debugger; on a bare board BKPT faults.
+ */
+#include <stdio.h>
+
+#include "cpu_defs.h"
+#include "regs.h"
+#include "tasks.h"
+#include "scheduler.h"
+
+#define BENCH_ITERATIONS        1000U
+#define BENCH_DELAY_ITERATIONS  50U
+#define BENCH_STACK_SIZE        256U
+
+/* Parked tasks on the delay list while the kernel paths are measured */
+#define BENCH_PARKED_TASKS      7
+
+/* Ticks the parked worker tasks sleep for, far beyond the benchmark run */
+#define BENCH_PARK_TICKS        1000000U
+
+
+extern uint16_t current_task;
+extern TCB_t tcb_pool[MAX_TASKS];
+extern sched_algo_t active_scheduler;
+
+void SysTick_Handler(void);
+
+typedef struct {
+    uint32_t n;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} bench_stat_t;
+
+
+/* ------------------------------------------------------------
+ * Semihosting output
+ * ------------------------------------------------------------ */
+
+#define SEMIHOST_SYS_WRITE0             0x04U
+#define SEMIHOST_SYS_EXIT               0x18U
+#define SEMIHOST_ADP_APPLICATION_EXIT   0x20026U
+
+static uint32_t semihost_call(uint32_t op, uint32_t arg){
+    register uint32_t r0 __asm("r0") = op;
+    register uint32_t r1 __asm("r1") = arg;
+
+    __asm volatile("BKPT 0xAB" : "+r"(r0) : "r"(r1) : "memory");
+    return r0;
+}
+
+static void semihost_puts(const char *s){
+    semihost_call(SEMIHOST_SYS_WRITE0, (uint32_t)s);
+}
+
+
+/* ------------------------------------------------------------
+ * Timer
+ * ------------------------------------------------------------ */
+
+static int use_dwt = 0;
+static uint32_t timer_overhead = 0;
+
+static inline uint32_t bench_now(void){
+    return use_dwt ? DWT_CYCCNT : TIM2_CNT;
+}
+
+static void bench_timer_init(void){
+    DCB_DEMCR |= DCB_DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    uint32_t before = DWT_CYCCNT;
+    for (volatile int i = 0; i < 16; i++);
+    use_dwt = (DWT_CYCCNT != before);
+
+    if (!use_dwt){
+        RCC_APB1ENR |= RCC_APB1ENR_TIM2EN;
+        TIM2_PSC = 0;
+        TIM2_ARR = 0xFFFFFFFFU;
+        TIM2_EGR = TIM_EGR_UG;
+        TIM2_CR1 = TIM_CR1_CEN;
+    }
+
+    /* Cost of an empty measurement, subtracted from direct-call samples */
+    uint32_t t0 = bench_now();
+    uint32_t t1 = bench_now();
+    timer_overhead = t1 - t0;
+}
+
+
+/* ------------------------------------------------------------
+ * Statistics
+ * ------------------------------------------------------------ */
+
+static void stat_reset(bench_stat_t *st){
+    st->n = 0;
+    st->min = UINT32_MAX;
+    st->max = 0;
+    st->sum = 0;
+}
+
+static void stat_add(bench_stat_t *st, uint32_t cycles){
+    st->n++;
+    st->sum += cycles;
+    if (cycles < st->min) st->min = cycles;
+    if (cycles > st->max) st->max = cycles;
+}
+
+static void stat_add_call(bench_stat_t *st, uint32_t t0, uint32_t t1){
+    uint32_t dt = t1 - t0;
+    stat_add(st, (dt > timer_overhead) ? dt - timer_overhead : 0U);
+}
+
+static void stat_report_timer(const char *name, const char *timer, const bench_stat_t *st){
+    char line[128];
+
+    snprintf(line, sizeof(line), "bench=%s timer=%s n=%lu min=%lu avg=%lu max=%lu\n",
+             name, timer, (unsigned long)st->n,
+             (unsigned long)(st->n ? st->min : 0U),
+             (unsigned long)(st->n ? (uint32_t)(st->sum / st->n) : 0U),
+             (unsigned long)st->max);
+    semihost_puts(line);
+}
+
+static void stat_report(const char *name, const bench_stat_t *st){
+    stat_report_timer(name, use_dwt ? "dwt" : "tim2", st);
+}
+
+
+/* ------------------------------------------------------------
+ * Helpers
+ * ------------------------------------------------------------ */
+
+/* Drop a context switch requested by a directly called kernel function */
+static void cancel_pending_switch(void){
+    SCB_ICSR = SCB_ICSR_PENDSVCLR;
+}
+
+
+
+/* ------------------------------------------------------------
+ * Tasks
+ * ------------------------------------------------------------ */
+
+static volatile uint32_t switch_t0 = 0;
+static volatile int partner_run = 0;
+static bench_stat_t switch_stat;
+
+
+static void idle_task(void *arg){
+    while(1){
+        scheduler_idle_sleep();
+    }
+}
+
+/* Populates the tcb_pool and delay list, then sleeps for the whole run */
+static void parked_task(void *arg){
+    while(1){
+        task_delay(BENCH_PARK_TICKS);
+    }
+}
+
+/* Other half of the context switch ping-pong */
+static void partner_task(void *arg){
+    while(partner_run){
+        stat_add(&switch_stat, bench_now() - switch_t0);
+        task_yield();
+    }
+    while(1){
+        task_delay(BENCH_PARK_TICKS);
+    }
+}
+
+
+static void bench_task(void *arg){
+    bench_stat_t st;
+    uint32_t t0, t1;
+
+    /* task_create: park some tasks, leaving room for the switch partner */
+    stat_reset(&st);
+    for (int i = 0; i < BENCH_PARKED_TASKS; i++){
+        t0 = bench_now();
+        int handle = task_create(parked_task, NULL, BENCH_STACK_SIZE, TASK_PRIORITY_MEDIUM);
+        t1 = bench_now();
+
+        if (handle < 0){
+            break;
+        }
+        stat_add_call(&st, t0, t1);
+
+        /* Equal priority, so no preemption: let it park itself on the delay list */
+        task_yield();
+    }
+    stat_report("task_create", &st);
+
+    /*
+     * Task selection for every policy. Only the selection is timed:
+     * update_next_task() would also charge runtime statistics, count a
+     * switch and emit trace events, changing the state measured later.
+     * scheduler_set_policy() also switches the ready queue layout, so each
+     * row measures its own queue; the original policy is restored at the end.
+     */
+    static const struct { sched_algo_t algo; const char *name; } algos[] = {
+        { SCHED_RR,       "select_next_task_rr" },
+        { SCHED_PRIORITY, "select_next_task_priority" },
+        { SCHED_EDF,      "select_next_task_edf" },
+    };
+    sched_algo_t saved_algo = active_scheduler;
+
+    for (uint32_t a = 0; a < sizeof(algos) / sizeof(algos[0]); a++){
+        scheduler_set_policy(algos[a].algo);
+
+        stat_reset(&st);
+        for (uint32_t i = 0; i < BENCH_ITERATIONS; i++){
+            CRITICAL_ENTER();
+            t0 = bench_now();
+            (void)scheduler_select_next_task();
+            t1 = bench_now();
+            CRITICAL_EXIT();
+            stat_add_call(&st, t0, t1);
+        }
+        stat_report(algos[a].name, &st);
+    }
+    scheduler_set_policy(saved_algo);
+
+    /* unblock_tasks with every parked task on the delay list, none due */
+    stat_reset(&st);
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++){
+        CRITICAL_ENTER();
+        t0 = bench_now();
+        unblock_tasks();
+        t1 = bench_now();
+        CRITICAL_EXIT();
+        stat_add_call(&st, t0, t1);
+    }
+    stat_report("unblock_tasks", &st);
+
+    /* SysTick handler body, called directly while the tick is stopped */
+    stat_reset(&st);
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++){
+        CRITICAL_ENTER();
+        t0 = bench_now();
+        SysTick_Handler();
+        t1 = bench_now();
+        cancel_pending_switch();
+        CRITICAL_EXIT();
+        stat_add_call(&st, t0, t1);
+    }
+    stat_report("systick_handler", &st);
+
+    /* Context switch: ping-pong with an equal-priority partner */
+    stat_reset(&switch_stat);
+    partner_run = 1;
+    task_create(partner_task, NULL, BENCH_STACK_SIZE, TASK_PRIORITY_MEDIUM);
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++){
+        switch_t0 = bench_now();
+        task_yield();
+    }
+    partner_run = 0;
+    task_yield();
+    stat_report("context_switch", &switch_stat);
+
+    /* task_delay(1) round trip and tick-to-task latency with a live tick */
+    bench_stat_t wake;
+    stat_reset(&st);
+    stat_reset(&wake);
+    init_systick_timer(TICK_HZ);
+    task_delay(1);  // align to a tick boundary
+    for (uint32_t i = 0; i < BENCH_DELAY_ITERATIONS; i++){
+        t0 = bench_now();
+        task_delay(1);
+        t1 = bench_now();
+
+        /* SysTick counts down from the reload at processor clock */
+        stat_add(&wake, SYST_RVR - SYST_CVR);
+        stat_add_call(&st, t0, t1);
+    }
+    stat_report("task_delay_1", &st);
+    stat_report_timer("tick_wake_latency", "systick", &wake);
+
+    semihost_puts("bench_done\n");
+    semihost_call(SEMIHOST_SYS_EXIT, SEMIHOST_ADP_APPLICATION_EXIT);
+
+    while(1);
+}
+
+
+int main(void){
+    bench_timer_init();
+
+    task_init();
+    task_create_idle(idle_task, NULL, BENCH_STACK_SIZE);
+    task_create(bench_task, NULL, 1024, TASK_PRIORITY_MEDIUM);
+
+    /* No SysTick yet: the tick is started by the delay benchmarks */
+    scheduler_start();
+
+    for(;;);
+}
@@ -0,0 +1,83 @@
+/*
+ * Ready queue selection benchmark (host)
+ * --------------------------------------
+ * Compares the O(1) bitmap ready queue against the former linear scan
+ * over the TCB array for a growing number of READY tasks. The bitmap
+ * cost should stay flat while the scan grows with the task count.
+ *
+ * Built by Port/Posix/CMakeLists.txt as ready-queue-bench.
+ *
+ * Output: one line per task count, "tasks=<n> scan_ns=<t> bitmap_ns=<t>"
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tasks.h"
+#include "ready_queue.h"
+
+#define MAX_BENCH_TASKS   1024
+#define ITERATIONS        2000000UL
+
+
+static TCB_t tcbs[MAX_BENCH_TASKS];
+static volatile uint32_t sink;
+
+
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+/* The selection loop used before the ready queue existed */
+static uint32_t linear_select(uint32_t n){
+    uint32_t selected = 0;
+    uint8_t best_prio = TASK_PRIORITY_IDLE;
+
+    for (uint32_t i = 1; i < n; i++){
+        if (tcbs[i].state == TASK_STATE_READY && tcbs[i].priority <= best_prio){
+            best_prio = tcbs[i].priority;
+            selected = i;
+        }
+    }
+    return selected;
+}
+
+
+static void setup(uint32_t n){
+    ready_queue_init();
+
+    for (uint32_t i = 0; i < n; i++){
+        list_node_init(&tcbs[i].state_node);
+        tcbs[i].state = TASK_STATE_READY;
+        /* idle at index 0, the rest spread over the user levels */
+        tcbs[i].priority = i ? (uint8_t)(rand() % TASK_PRIORITY_IDLE) : TASK_PRIORITY_IDLE;
+        ready_queue_insert(&tcbs[i]);
+    }
+}
+
+
+int main(void){
+    for (uint32_t n = 4; n <= MAX_BENCH_TASKS; n *= 2){
+        setup(n);
+
+        uint64_t t0 = now_ns();
+        for (unsigned long it = 0; it < ITERATIONS; it++){
+            sink = linear_select(n);
+        }
+        uint64_t t1 = now_ns();
+        for (unsigned long it = 0; it < ITERATIONS; it++){
+            /* select and give the next equal-priority task its turn */
+            TCB_t *next = ready_queue_peek();
+            ready_queue_rotate(next);
+            sink = (uint32_t)(next - tcbs);
+        }
+        uint64_t t2 = now_ns();
+
+        printf("tasks=%lu scan_ns=%.2f bitmap_ns=%.2f\n", (unsigned long)n,
+               (double)(t1 - t0) / ITERATIONS, (double)(t2 - t1) / ITERATIONS);
+    }
+    return 0;
+}
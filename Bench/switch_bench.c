@@ -0,0 +1,75 @@
+/*
+ * Context switch throughput benchmark (POSIX port)
+ * ------------------------------------------------
+ * BENCH_TASKS tasks of equal priority hand the CPU to each other in a
+ * loop, so every iteration is one full kernel switch: ready queue
+ * rotation, update_next_task() and a port context switch.
+ *
+ * Built by Port/Posix/CMakeLists.txt as switch-bench. Also suitable for
+ * perf record / valgrind --tool=callgrind.
+ *
+ * Output: "switches=<n> seconds=<t> switches_per_sec=<r> ns_per_switch=<t>"
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cpu_defs.h"
+#include "tasks.h"
+#include "scheduler.h"
+
+#define BENCH_TASKS        4
+#define BENCH_SWITCHES     2000000UL
+
+
+extern uint16_t current_task;
+extern TCB_t tcb_pool[MAX_TASKS];
+
+static volatile unsigned long switches = 0;
+static struct timespec start;
+
+
+static double elapsed_s(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start.tv_sec) + (double)(now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+
+
+
+static void idle_task(void *arg){
+    while(1){
+        scheduler_idle_sleep();
+    }
+}
+
+
+static void worker_task(void *arg){
+    while(1){
+        if (++switches >= BENCH_SWITCHES){
+            CRITICAL_ENTER();
+            double s = elapsed_s();
+            printf("switches=%lu seconds=%.3f switches_per_sec=%.0f ns_per_switch=%.1f\n",
+                   (unsigned long)switches, s, (double)switches / s, s * 1e9 / (double)switches);
+            exit(EXIT_SUCCESS);
+        }
+        task_yield();
+    }
+}
+
+
+int main(void){
+    task_init();
+
+    task_create_idle(idle_task, NULL, 256);
+    for (int i = 0; i < BENCH_TASKS; i++){
+        task_create(worker_task, NULL, 512, TASK_PRIORITY_MEDIUM);
+    }
+
+    init_systick_timer(TICK_HZ);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    scheduler_start();
+    return 0;
+}
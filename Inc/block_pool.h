@@ -0,0 +1,51 @@
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <stdint.h>
+#include "list.h"
+
+/*
+ * Block pool
+ * ----------
+ * Fixed-size block allocator for message payloads. Free blocks are kept
+ * on a singly-linked free list threaded through the blocks themselves,
+ * so allocation and release are O(1) and need no extra memory.
+ *
+ * A task can wait for a block to be freed (priority-ordered). Freeing a
+ * block while a task waits hands it straight to that task.
+ *
+ * block_free() and block_alloc() with a timeout of 0 may be called from
+ * interrupt handlers.
+ */
+
+typedef struct {
+    void *free_list;            // First free block, NULL if exhausted
+    uint32_t block_size;        // Bytes per block
+    uint32_t block_count;       // Blocks in the pool
+    uint32_t free_count;        // Blocks currently free
+    uint8_t *start;             // Storage bounds, for checking frees
+    uint8_t *end;
+    list_t waiters;             // Tasks waiting in block_alloc()
+} block_pool_t;
+
+
+/* Pool of MSG_POOL_BLOCK_COUNT blocks of MSG_POOL_BLOCK_SIZE bytes (tasks.c) */
+extern block_pool_t msg_pool;
+
+
+/*
+ * Build a pool over storage of block_count * block_size bytes.
+ * block_size is rounded up to 8 bytes. Returns -1 on bad arguments.
+ */
+int block_pool_init(block_pool_t *pool, void *storage, uint32_t block_size, uint32_t block_count);
+
+/*
+ * Allocate a block, waiting at most timeout_ticks ticks (WAIT_FOREVER to
+ * wait indefinitely, 0 to not wait). Returns NULL on timeout.
+ */
+void *block_alloc(block_pool_t *pool, uint32_t timeout_ticks);
+
+/* Return a block to its pool. Returns -1 if it does not belong to the pool */
+int block_free(block_pool_t *pool, void *block);
+
+#endif /* BLOCK_POOL_H */
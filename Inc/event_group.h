@@ -0,0 +1,56 @@
+#ifndef EVENT_GROUP_H
+#define EVENT_GROUP_H
+
+#include <stdint.h>
+#include "list.h"
+
+/*
+ * Event group
+ * -----------
+ * 32 event bits that tasks can wait on. A waiter asks for any or all of
+ * a set of bits and may clear them when its wait completes. Waiters are
+ * kept in priority order, so when one event satisfies several tasks the
+ * highest priority one is released first.
+ *
+ * event_group_set(), event_group_clear() and event_group_get() may be
+ * called from interrupt handlers. event_group_wait() with a timeout of
+ * 0 may be called anywhere; blocking waits are for tasks only (not the
+ * idle task).
+ */
+
+/* event_group_wait() flags */
+#define EVENT_WAIT_ANY          0x00U   // Any of the requested bits
+#define EVENT_WAIT_ALL          0x01U   // All of the requested bits
+#define EVENT_CLEAR_ON_EXIT     0x02U   // Clear the requested bits when the wait succeeds
+
+typedef struct {
+    uint32_t bits;              // Current event bits
+    list_t waiters;             // Blocked tasks, highest priority first
+} event_group_t;
+
+
+void event_group_init(event_group_t *group);
+
+/*
+ * Set bits and release every waiter whose condition is now met.
+ * Returns the bits after waiters with EVENT_CLEAR_ON_EXIT cleared theirs.
+ */
+uint32_t event_group_set(event_group_t *group, uint32_t bits);
+
+/* Clear bits. Returns the bits before clearing */
+uint32_t event_group_clear(event_group_t *group, uint32_t bits);
+
+uint32_t event_group_get(const event_group_t *group);
+
+/*
+ * Wait until any (EVENT_WAIT_ANY) or all (EVENT_WAIT_ALL) of bits are
+ * set, at most timeout_ticks ticks (WAIT_FOREVER to wait indefinitely).
+ * On success *result (if not NULL) holds the event bits at the moment
+ * the condition was met, before any clearing. On timeout it holds the
+ * current bits.
+ * Returns 0 on success, -1 on timeout or if bits is 0.
+ */
+int event_group_wait(event_group_t *group, uint32_t bits, uint8_t flags,
+                     uint32_t timeout_ticks, uint32_t *result);
+
+#endif /* EVENT_GROUP_H */
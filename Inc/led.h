@@ -2,13 +2,15 @@
 #define LED_H_
 
 #include <stdint.h>
+#include "system.h"
 
 #define LED_GREEN  12
 #define LED_ORANGE 13
 #define LED_RED    14
 #define LED_BLUE   15
 
-#define DELAY_COUNT_1MS 		 1250U
+/* The delay() loop takes about 12.8 cycles per count at -O0 */
+#define DELAY_COUNT_1MS 		(system_core_clock() / 12800U)
 #define DELAY_COUNT_1S  		(1000U * DELAY_COUNT_1MS)
 #define DELAY_COUNT_500MS  		(500U  * DELAY_COUNT_1MS)
 #define DELAY_COUNT_250MS 		(250U  * DELAY_COUNT_1MS)
@@ -17,6 +19,7 @@
 void led_init_all(void);
 void led_on(uint8_t led_no);
 void led_off(uint8_t led_no);
+void led_toggle(uint8_t led_no);
 void delay(uint32_t count);
 
 #endif /* LED_H_ */
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef LIST_H
+#define LIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Intrusive circular doubly-linked list.
+ *
+ * The list head is a sentinel node, so insert/remove never need to
+ * special-case an empty list and a node can be unlinked without
+ * knowing which list it is on. A node whose next pointer is NULL is
+ * not linked into any list.
+ */
+typedef struct list_node {
+    struct list_node *next;
+    struct list_node *prev;
+} list_node_t;
+
+typedef list_node_t list_t;
+
+/* Get the structure that embeds a list node */
+#define LIST_ENTRY(node, type, member) \
+    ((type *)((uint8_t *)(node) - offsetof(type, member)))
+
+
+static inline void list_init(list_t *list){
+    list->next = list;
+    list->prev = list;
+}
+
+static inline void list_node_init(list_node_t *node){
+    node->next = NULL;
+    node->prev = NULL;
+}
+
+static inline int list_empty(const list_t *list){
+    return list->next == list;
+}
+
+static inline int list_node_linked(const list_node_t *node){
+    return node->next != NULL;
+}
+
+/* First node of the list, or NULL if the list is empty */
+static inline list_node_t *list_first(const list_t *list){
+    return list_empty(list) ? NULL : list->next;
+}
+
+/* Insert node in front of pos (pos may be the list head to append) */
+static inline void list_insert_before(list_node_t *pos, list_node_t *node){
+    node->next = pos;
+    node->prev = pos->prev;
+    pos->prev->next = node;
+    pos->prev = node;
+}
+
+static inline void list_push_back(list_t *list, list_node_t *node){
+    list_insert_before(list, node);
+}
+
+static inline void list_remove(list_node_t *node){
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = NULL;
+    node->prev = NULL;
+}
+
+#endif /* LIST_H */
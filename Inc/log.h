@@ -0,0 +1,83 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include "tasks.h"
+
+/*
+ * Deferred logging
+ * ----------------
+ * LOG("fmt", args...) stores a record (format string reference, tick
+ * and up to LOG_MAX_ARGS raw 32-bit arguments) in a lock-free RAM ring
+ * and returns; nothing is formatted or sent on the caller's time. A
+ * low-priority drain task (log_service_start()) empties the ring in
+ * bulk through port_log_emit(): on Cortex-M as 32-bit words on ITM
+ * stimulus port LOG_ITM_PORT, decoded back into text on the host by
+ * Tools/log_decode.py; on the POSIX port it is printed directly.
+ *
+ * Format strings are placed in the .logstr section, which the firmware
+ * linker script keeps out of flash: on target a format string is only
+ * an ID (its offset in .logstr), read back from the ELF by the decoder.
+ * Consequently the arguments must be integers (%d %i %u %x %X %o %c,
+ * with flags and width). %s cannot work, and pointers or floats have
+ * to be cast or scaled to a 32-bit integer by the caller.
+ *
+ * Any number of tasks and interrupt handlers may log concurrently: a
+ * slot is claimed with a compare-and-swap on the ring head and published
+ * by writing its sequence number last. When the ring is full the record
+ * is dropped and counted; the drain task reports the count.
+ */
+
+#define LOG_MAX_ARGS            4U
+#define LOG_RING_RECORDS        64U     // Power of two
+#define LOG_DRAIN_TICKS         10U     // Drain task period
+#define LOG_ITM_PORT            1U      // Stimulus port 0 stays with printf
+
+
+/* One ring slot */
+typedef struct {
+    uint32_t seq;               // Ring position + 1 once the record is complete
+    const char *fmt;            // Format string in .logstr
+    uint32_t timestamp;         // g_tick_count when logged
+    uint32_t nargs;
+    uint32_t args[LOG_MAX_ARGS];
+} log_record_t;
+
+
+/* Store a record; use LOG() instead. Safe from tasks and interrupt handlers */
+void log_write(const char *fmt, const uint32_t *args, uint32_t nargs);
+
+/* Emit every complete record now. Only one context may flush (normally the drain task) */
+void log_flush(void);
+
+/* Create the drain task. Returns -1 if the task cannot be created */
+int log_service_start(uint32_t stack_size, task_priority_t priority);
+
+
+/* ------------------------------------------------------------
+ * LOG() macro
+ * ------------------------------------------------------------ */
+
+#define LOG_STR_ATTR            __attribute__((section(".logstr"), aligned(1)))
+
+#define LOG(...)                LOG_CAT_(LOG_, LOG_NARGS_(__VA_ARGS__, 4, 3, 2, 1, 0, ~))(__VA_ARGS__)
+
+#define LOG_0(fmt)              LOG_RECORD_(fmt, 0U, 0U)
+#define LOG_1(fmt, a)           LOG_RECORD_(fmt, 1U, LOG_ARG_(a))
+#define LOG_2(fmt, a, b)        LOG_RECORD_(fmt, 2U, LOG_ARG_(a), LOG_ARG_(b))
+#define LOG_3(fmt, a, b, c)     LOG_RECORD_(fmt, 3U, LOG_ARG_(a), LOG_ARG_(b), LOG_ARG_(c))
+#define LOG_4(fmt, a, b, c, d)  LOG_RECORD_(fmt, 4U, LOG_ARG_(a), LOG_ARG_(b), LOG_ARG_(c), LOG_ARG_(d))
+
+#define LOG_RECORD_(fmt, n, ...)                                    \
+    do {                                                            \
+        static const char log_fmt_[] LOG_STR_ATTR = fmt;            \
+        const uint32_t log_args_[] = { __VA_ARGS__ };               \
+        log_write(log_fmt_, log_args_, n);                          \
+    } while (0)
+
+#define LOG_ARG_(x)             ((uint32_t)(x))
+#define LOG_NARGS_(fmt, a, b, c, d, n, ...) n
+#define LOG_CAT_(a, b)          LOG_CAT2_(a, b)
+#define LOG_CAT2_(a, b)         a##b
+
+#endif /* LOG_H */
@@ -0,0 +1,57 @@
+#ifndef MSG_QUEUE_H
+#define MSG_QUEUE_H
+
+#include <stdint.h>
+#include "list.h"
+
+/*
+ * Message queue
+ * -------------
+ * Zero-copy FIFO of message pointers. A sender allocates a block (for
+ * example from msg_pool, block_pool.h), fills it in place and posts the
+ * pointer; the receiver takes ownership and frees the block when done.
+ * Payloads are never copied by the queue.
+ *
+ * Receivers and senders blocked on a full queue wait in priority order.
+ * A message posted while a receiver waits is handed straight to the
+ * highest priority receiver, and a receive from a full queue moves the
+ * first blocked sender's message in.
+ *
+ * msg_queue_send_from_isr() never blocks and may be called from
+ * interrupt handlers.
+ */
+
+typedef struct {
+    void **slots;               // Ring of message pointers
+    uint32_t capacity;          // Number of slots
+    uint32_t head;              // Index of the oldest message
+    uint32_t count;             // Messages in the queue
+    list_t receivers;           // Tasks blocked in msg_queue_receive()
+    list_t senders;             // Tasks blocked in msg_queue_send()
+} msg_queue_t;
+
+
+/* storage holds capacity pointers. Returns -1 on bad arguments */
+int msg_queue_init(msg_queue_t *queue, void **storage, uint32_t capacity);
+
+/*
+ * Post a message, waiting at most timeout_ticks ticks for a free slot
+ * (WAIT_FOREVER to wait indefinitely, 0 to not wait).
+ * Returns 0 on success, -1 on timeout (the caller still owns msg).
+ */
+int msg_queue_send(msg_queue_t *queue, void *msg, uint32_t timeout_ticks);
+
+/* Non-blocking post for interrupt handlers. Returns -1 if the queue is full */
+int msg_queue_send_from_isr(msg_queue_t *queue, void *msg);
+
+/*
+ * Take the oldest message, waiting at most timeout_ticks ticks
+ * (WAIT_FOREVER to wait indefinitely, 0 to not wait).
+ * Returns the message, NULL on timeout.
+ */
+void *msg_queue_receive(msg_queue_t *queue, uint32_t timeout_ticks);
+
+/* Messages currently queued */
+uint32_t msg_queue_count(const msg_queue_t *queue);
+
+#endif /* MSG_QUEUE_H */
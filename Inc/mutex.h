@@ -0,0 +1,62 @@
+#ifndef MUTEX_H
+#define MUTEX_H
+
+#include <stdint.h>
+#include "list.h"
+#include "tasks.h"
+
+/*
+ * Mutex
+ * -----
+ * Blocking, non-recursive mutex with priority inheritance. While a task
+ * waits for a mutex, the owner runs at least at the waiter's priority,
+ * and so does the owner of any mutex that owner is blocked on. A
+ * TASK_PRIORITY_HIGH task therefore waits only for the owner's critical
+ * section, never for unrelated medium priority tasks.
+ *
+ * On unlock ownership passes directly to the highest priority waiter
+ * (FIFO among equal priorities). Waiting tasks are in the
+ * TASK_STATE_BLOCKED_OBJ state and cost nothing on the tick unless they
+ * have a timeout.
+ *
+ * Task context only; mutexes cannot be used from interrupt handlers or
+ * by the idle task.
+ */
+
+typedef struct mutex {
+    TCB_t *owner;               // Owning task, NULL if free
+    list_t waiters;             // Blocked tasks, highest priority first
+    list_node_t held_node;      // Link in the owner's mutexes_held list
+} mutex_t;
+
+
+void mutex_init(mutex_t *mutex);
+
+/*
+ * Take the mutex, waiting at most timeout_ticks ticks (WAIT_FOREVER to
+ * wait indefinitely, 0 to not wait at all).
+ * Returns 0 once the mutex is owned, -1 on timeout or if the caller
+ * already owns it.
+ */
+int mutex_lock(mutex_t *mutex, uint32_t timeout_ticks);
+
+/* Take the mutex only if it is free. Returns 0 on success, -1 otherwise */
+int mutex_trylock(mutex_t *mutex);
+
+/* Release the mutex. Returns -1 if the caller is not the owner */
+int mutex_unlock(mutex_t *mutex);
+
+/*
+ * Recompute the effective priority of a task from its base priority and
+ * the waiters of the mutexes it holds, and pass the change down the
+ * chain of mutex owners. Must be called inside a kernel critical section (CRITICAL_ENTER).
+ */
+void mutex_priority_update(TCB_t *tcb);
+
+/*
+ * Release every mutex a task holds, as if it unlocked them (used when
+ * the task is deleted). Must be called inside a kernel critical section (CRITICAL_ENTER).
+ */
+void mutex_release_all(TCB_t *tcb);
+
+#endif /* MUTEX_H */
@@ -0,0 +1,51 @@
+#ifndef NOTIFY_H
+#define NOTIFY_H
+
+#include <stdint.h>
+#include "tasks.h"
+
+/*
+ * Direct-to-task notifications
+ * ----------------------------
+ * Every task has a 32-bit notification word and a pending state in its
+ * TCB. A notification updates the word and, if the task is blocked in
+ * task_notify_wait(), wakes it through the normal scheduler path (with
+ * immediate preemption if it outranks the notifier). No kernel object
+ * is needed, which makes it the cheapest way for one ISR or task to
+ * signal one other task: a counting signal (NOTIFY_INCREMENT), an event
+ * mask (NOTIFY_SET_BITS) or a mailbox value (NOTIFY_OVERWRITE).
+ */
+
+/* TCB_t.notify_state */
+#define NOTIFY_STATE_IDLE       0U      // Nothing pending, not waiting
+#define NOTIFY_STATE_PENDING    1U      // Notified, not yet consumed
+#define NOTIFY_STATE_WAITING    2U      // Blocked in task_notify_wait()
+
+typedef enum {
+    NOTIFY_NO_ACTION = 0,   // Only mark pending, the value is unchanged
+    NOTIFY_SET_BITS,        // value |= arg
+    NOTIFY_INCREMENT,       // value += 1 (arg ignored)
+    NOTIFY_OVERWRITE,       // value = arg
+    NOTIFY_NO_OVERWRITE,    // value = arg, unless a notification is pending
+} notify_action_t;
+
+
+/*
+ * Notify a task.
+ * Returns 0 on success, -1 for an invalid handle or if NOTIFY_NO_OVERWRITE
+ * finds a notification still pending.
+ */
+int task_notify(task_handle_t task, uint32_t value, notify_action_t action);
+
+/* Same as task_notify(), for interrupt handlers */
+int task_notify_from_isr(task_handle_t task, uint32_t value, notify_action_t action);
+
+/*
+ * Wait for a notification to the calling task, at most timeout_ticks
+ * ticks (WAIT_FOREVER to wait indefinitely, 0 to only poll).
+ * On success the notification word is stored in *value (if not NULL)
+ * and reset to 0. Returns 0 on success, -1 on timeout.
+ */
+int task_notify_wait(uint32_t timeout_ticks, uint32_t *value);
+
+#endif /* NOTIFY_H */
@@ -0,0 +1,70 @@
+#ifndef PORT_H
+#define PORT_H
+
+#include <stdint.h>
+#include "tasks.h"
+
+/*
+ * Port interface
+ * --------------
+ * Everything the kernel needs from the CPU. scheduler.c and tasks.c only
+ * talk to the hardware through these functions and the critical section
+ * macros of the port's cpu_defs.h.
+ *
+ * Ports:
+ *   Port/CM4    Cortex-M4 (PendSV, SysTick, PSP)
+ *   Port/Posix  Linux process (ucontext, SIGALRM)
+ */
+
+/*
+ * Build the initial context of a task on its stack so that the first
+ * switch to it starts entry(arg). Returns the value stored in TCB_t.psp.
+ */
+uint32_t *port_init_stack(uint8_t *stack_base, uint32_t stack_size, task_func_t entry, void *arg);
+
+/*
+ * A deleted task's context (the psp value from port_init_stack) will not
+ * be switched to again. Called in a critical section, possibly by the
+ * task itself; the context is still used to switch away from it.
+ */
+void port_release_context(uint32_t *psp);
+
+/*
+ * Start running the task selected by update_next_task().
+ * Called with INTERRUPT_DISABLE() in effect, never returns; the first
+ * task starts with interrupts enabled and no critical section held.
+ */
+void port_start_first_task(void);
+
+/* Request a context switch; it happens at the outermost CRITICAL_EXIT() */
+void port_pend_switch(void);
+
+/* Sleep until the next interrupt. Called with interrupts enabled. */
+void port_wait_for_interrupt(void);
+
+/*
+ * Tickless idle: suppress the tick for up to expected_ticks and sleep.
+ * Called in a critical section. Returns the number of whole ticks that
+ * passed and still have to be added to g_tick_count (a tick whose
+ * interrupt is already pending is not included).
+ */
+uint32_t port_tickless_sleep(uint32_t expected_ticks);
+
+/*
+ * Free-running counter for runtime accounting (TIM5 on Cortex-M). It must
+ * keep running while the core sleeps, so idle time is accounted for.
+ * Only differences are used, so it may wrap. port_runtime_counter_hz()
+ * is its rate, read at run time because it follows the core clock.
+ */
+void port_init_runtime_counter(void);
+uint32_t port_runtime_counter(void);
+uint32_t port_runtime_counter_hz(void);
+
+/*
+ * Deferred log output (log.c drain task): send one record. fmt is an
+ * ID on targets that keep format strings out of memory (.logstr) and
+ * must not be dereferenced there.
+ */
+void port_log_emit(const char *fmt, uint32_t timestamp, const uint32_t *args, uint32_t nargs);
+
+#endif /* PORT_H */
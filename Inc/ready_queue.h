@@ -0,0 +1,57 @@
+#ifndef READY_QUEUE_H
+#define READY_QUEUE_H
+
+#include <stdint.h>
+#include "tasks.h"
+
+/*
+ * Ready queue
+ * -----------
+ * One FIFO list of READY tasks per priority level plus a 32-bit bitmap
+ * with one bit per non-empty level. Bit (31 - prio) is used for level
+ * prio, so CLZ of the bitmap directly yields the highest ready priority
+ * and selection costs the same no matter how many tasks exist.
+ *
+ * The running task stays in its ready list. Rotating it to the tail
+ * gives the next task of the same priority its turn.
+ *
+ * In round-robin mode every task except those at TASK_PRIORITY_IDLE is
+ * queued on level 0, so the same head-of-list selection and tail
+ * rotation give plain round-robin, also in O(1).
+ *
+ * In deadline mode (EDF) the same level 0 list is kept sorted by
+ * absolute deadline, tasks without a deadline last. Selection stays
+ * O(1); inserting costs a walk over the ready tasks with earlier
+ * deadlines, and rotation only moves a task behind those with the same
+ * deadline.
+ *
+ * All functions must be called inside a kernel critical section.
+ */
+
+void ready_queue_init(void);
+
+typedef enum {
+    READY_QUEUE_PRIORITY,       // One FIFO list per priority
+    READY_QUEUE_SINGLE,         // One FIFO list (round-robin)
+    READY_QUEUE_DEADLINE,       // One list ordered by deadline (EDF)
+} ready_queue_mode_t;
+
+/* Queue tasks inserted from now on according to mode */
+void ready_queue_set_mode(ready_queue_mode_t mode);
+
+/* Append a READY task to the tail of its priority list */
+void ready_queue_insert(TCB_t *tcb);
+
+/* Remove a task from its priority list */
+void ready_queue_remove(TCB_t *tcb);
+
+/* Head of the highest non-empty priority list, NULL if nothing is ready */
+TCB_t *ready_queue_peek(void);
+
+/* Non-zero if tcb is the only READY task */
+int ready_queue_is_only(const TCB_t *tcb);
+
+/* Move a ready task behind the other tasks of the same priority */
+void ready_queue_rotate(TCB_t *tcb);
+
+#endif /* READY_QUEUE_H */
@@ -4,7 +4,71 @@
 #include <stdint.h>
 
 /* -------------------- RCC -------------------- */
+#define RCC_CR        (*(volatile uint32_t*)0x40023800U)
+#define RCC_PLLCFGR   (*(volatile uint32_t*)0x40023804U)
+#define RCC_CFGR      (*(volatile uint32_t*)0x40023808U)
 #define RCC_AHB1ENR   (*(volatile uint32_t*)0x40023830U)
+#define RCC_APB1ENR   (*(volatile uint32_t*)0x40023840U)
+
+#define RCC_APB1ENR_TIM2EN  (1U << 0)
+#define RCC_APB1ENR_TIM5EN  (1U << 3)
+#define RCC_APB1ENR_PWREN   (1U << 28)
+
+#define RCC_CR_HSEON            (1U << 16)
+#define RCC_CR_HSERDY           (1U << 17)
+#define RCC_CR_PLLON            (1U << 24)
+#define RCC_CR_PLLRDY           (1U << 25)
+
+#define RCC_PLLCFGR_PLLM(m)     ((uint32_t)(m) << 0)            // VCO input = source / M
+#define RCC_PLLCFGR_PLLN(n)     ((uint32_t)(n) << 6)            // VCO = input * N
+#define RCC_PLLCFGR_PLLP(p)     ((((uint32_t)(p) / 2U) - 1U) << 16)  // SYSCLK = VCO / P (2, 4, 6, 8)
+#define RCC_PLLCFGR_PLLSRC_HSE  (1U << 22)
+#define RCC_PLLCFGR_PLLQ(q)     ((uint32_t)(q) << 24)           // USB/SDIO = VCO / Q
+#define RCC_PLLCFGR_MASK        0x0F437FFFU                     // all of the above, the rest is reserved
+
+#define RCC_CFGR_SW_MASK        (3U << 0)
+#define RCC_CFGR_SW_PLL         (2U << 0)
+#define RCC_CFGR_SWS_MASK       (3U << 2)
+#define RCC_CFGR_SWS_HSI        (0U << 2)
+#define RCC_CFGR_SWS_HSE        (1U << 2)
+#define RCC_CFGR_SWS_PLL        (2U << 2)
+#define RCC_CFGR_HPRE_MASK      (0xFU << 4)
+#define RCC_CFGR_PPRE1_MASK     (7U << 10)
+#define RCC_CFGR_PPRE1_DIV4     (5U << 10)
+#define RCC_CFGR_PPRE2_DIV2     (4U << 13)
+#define RCC_CFGR_PPRE_MASK      (0x3FU << 10)
+
+/* -------------------- PWR -------------------- */
+#define PWR_CR        (*(volatile uint32_t*)0x40007000U)
+
+#define PWR_CR_VOS              (1U << 14)      // Regulator scale 1 (needed above 144 MHz)
+
+/* -------------------- FLASH -------------------- */
+#define FLASH_ACR     (*(volatile uint32_t*)0x40023C00U)
+
+#define FLASH_ACR_LATENCY(ws)   ((uint32_t)(ws) << 0)
+#define FLASH_ACR_PRFTEN        (1U << 8)       // ART prefetch
+#define FLASH_ACR_ICEN          (1U << 9)       // ART instruction cache
+#define FLASH_ACR_DCEN          (1U << 10)      // ART data cache
+#define FLASH_ACR_ICRST         (1U << 11)
+#define FLASH_ACR_DCRST         (1U << 12)
+
+/* -------------------- TIM2 (32-bit general purpose timer) -------------------- */
+#define TIM2_CR1      (*(volatile uint32_t*)0x40000000U)
+#define TIM2_EGR      (*(volatile uint32_t*)0x40000014U)
+#define TIM2_CNT      (*(volatile uint32_t*)0x40000024U)
+#define TIM2_PSC      (*(volatile uint32_t*)0x40000028U)
+#define TIM2_ARR      (*(volatile uint32_t*)0x4000002CU)
+
+/* -------------------- TIM5 (32-bit general purpose timer) -------------------- */
+#define TIM5_CR1      (*(volatile uint32_t*)0x40000C00U)
+#define TIM5_EGR      (*(volatile uint32_t*)0x40000C14U)
+#define TIM5_CNT      (*(volatile uint32_t*)0x40000C24U)
+#define TIM5_PSC      (*(volatile uint32_t*)0x40000C28U)
+#define TIM5_ARR      (*(volatile uint32_t*)0x40000C2CU)
+
+#define TIM_CR1_CEN   (1U << 0)
+#define TIM_EGR_UG    (1U << 0)
 
 /* -------------------- GPIO -------------------- */
 #define GPIOD_MODER   (*(volatile uint32_t*)0x40020C00U)
@@ -19,6 +83,9 @@
 #define SYST_CSR_ENABLE     (1U << 0) // enables the counter
 #define SYST_CSR_TICKINT    (1U << 1) // enables systick exception request
 #define SYST_CSR_CLKSOURCE  (1U << 2) // sets the processors clock source (not external)
+#define SYST_CSR_COUNTFLAG  (1U << 16) // counter reached 0 since last read (cleared on read)
+
+#define SYST_RVR_MAX        0x00FFFFFFU // 24-bit reload value
 
 
 /* -------------------- SCB -------------------- */
@@ -27,6 +94,8 @@
 #define SCB_SHPR3     (*(volatile uint32_t*)0xE000ED20U)
 
 /* ICSR bit definitions*/
+#define SCB_ICSR_PENDSTSET      (1U << 26)
+#define SCB_ICSR_PENDSVCLR      (1U << 27)
 #define SCB_ICSR_PENDSVSET      (1U << 28)
 
 /* SHCSR bit definitions */
@@ -34,5 +103,66 @@
 #define SCB_SHCSR_BUSFAULTENA   (1U << 17)
 #define SCB_SHCSR_USGFAULTENA   (1U << 18)
 
+/* Fault status */
+#define SCB_CFSR      (*(volatile uint32_t*)0xE000ED28U)
+#define SCB_MMFAR     (*(volatile uint32_t*)0xE000ED34U)
+
+/* CFSR MemManage status bits (MMFSR, bits 0-7) */
+#define SCB_CFSR_IACCVIOL       (1U << 0)   // instruction access violation
+#define SCB_CFSR_DACCVIOL       (1U << 1)   // data access violation
+#define SCB_CFSR_MUNSTKERR      (1U << 3)   // fault on exception return unstacking
+#define SCB_CFSR_MSTKERR        (1U << 4)   // fault on exception entry stacking
+#define SCB_CFSR_MLSPERR        (1U << 5)   // fault during lazy FP state preservation
+#define SCB_CFSR_MMARVALID      (1U << 7)   // MMFAR holds the faulting address
+#define SCB_CFSR_MMFSR_MASK     0xFFU
+
+
+/* -------------------- MPU -------------------- */
+#define MPU_TYPE      (*(volatile uint32_t*)0xE000ED90U)
+#define MPU_CTRL      (*(volatile uint32_t*)0xE000ED94U)
+#define MPU_RNR       (*(volatile uint32_t*)0xE000ED98U)
+#define MPU_RBAR      (*(volatile uint32_t*)0xE000ED9CU)
+#define MPU_RASR      (*(volatile uint32_t*)0xE000EDA0U)
+
+#define MPU_TYPE_DREGION_Pos    8U          // number of data regions
+#define MPU_TYPE_DREGION_Msk    (0xFFU << MPU_TYPE_DREGION_Pos)
+
+#define MPU_CTRL_ENABLE         (1U << 0)
+#define MPU_CTRL_PRIVDEFENA     (1U << 2)   // default memory map for privileged accesses
+
+#define MPU_RBAR_VALID          (1U << 4)   // RBAR[3:0] selects the region
+
+#define MPU_RASR_ENABLE         (1U << 0)
+#define MPU_RASR_SIZE(log2)     (((log2) - 1U) << 1)  // region size 2^log2 bytes
+#define MPU_RASR_AP_NONE        (0U << 24)  // no access, privileged or not
+#define MPU_RASR_XN             (1U << 28)  // execute never
+
+
+/* -------------------- FPU -------------------- */
+#define SCB_CPACR     (*(volatile uint32_t*)0xE000ED88U)
+#define FPU_FPCCR     (*(volatile uint32_t*)0xE000EF34U)
+
+#define SCB_CPACR_CP10_CP11_FULL  (0xFU << 20)  // full access to CP10/CP11 (FPU)
+#define FPU_FPCCR_LSPEN           (1U << 30)    // lazy state preservation
+#define FPU_FPCCR_ASPEN           (1U << 31)    // set CONTROL.FPCA on FP use
+
+
+/* -------------------- DCB / DWT (cycle counter) -------------------- */
+#define DCB_DEMCR     (*(volatile uint32_t*)0xE000EDFCU)
+#define DWT_CTRL      (*(volatile uint32_t*)0xE0001000U)
+#define DWT_CYCCNT    (*(volatile uint32_t*)0xE0001004U)
+
+#define DCB_DEMCR_TRCENA        (1U << 24)
+#define DWT_CTRL_CYCCNTENA      (1U << 0)
+
+
+/* -------------------- ITM (instrumentation trace) -------------------- */
+#define ITM_STIM(n)   (*(volatile uint32_t*)(0xE0000000U + 4U * (n)))
+#define ITM_TER       (*(volatile uint32_t*)0xE0000E00U)
+#define ITM_TCR       (*(volatile uint32_t*)0xE0000E80U)
+
+#define ITM_STIM_FIFOREADY      (1U << 0)
+#define ITM_TCR_ITMENA          (1U << 0)
+
 
 #endif
@@ -0,0 +1,65 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+#include "list.h"
+#include "tasks.h"
+
+/*
+ * Ring buffer
+ * -----------
+ * Lock-free single-producer, single-consumer byte ring for streaming data
+ * from an ISR (ADC, UART, ...) into a task, or between two tasks.
+ *
+ * head is written only by the producer and tail only by the consumer.
+ * Both run freely and wrap at 2^32, and the capacity is a power of two,
+ * so the fill level is (head - tail) and slots are found with a mask.
+ * Acquire/release ordering on the two indices is all the synchronisation
+ * needed, so push and pop never disable interrupts.
+ *
+ * ring_read() blocks the consumer task until data arrives. The producer
+ * only enters the scheduler (briefly, in a kernel critical section) when
+ * a reader is actually waiting.
+ *
+ * Exactly one context may push and exactly one may pop.
+ *
+ * Waking the reader is a kernel call, so a producer ISR running above
+ * KERNEL_MAX_SYSCALL_PRIORITY (not masked by kernel critical sections)
+ * may push only into a ring that is never read with ring_read(); the
+ * consumer then polls with ring_pop_n() instead.
+ */
+
+typedef struct {
+    uint8_t *buf;               // Storage, capacity bytes
+    uint32_t mask;              // capacity - 1
+    uint32_t head;              // Next write index (producer)
+    uint32_t tail;              // Next read index (consumer)
+    list_t readers;             // Consumer blocked in ring_read(), if any
+} ring_buffer_t;
+
+
+/* capacity must be a power of two. Returns -1 otherwise */
+int ring_init(ring_buffer_t *ring, uint8_t *storage, uint32_t capacity);
+
+/* Copy up to n bytes in. Returns the number of bytes written */
+uint32_t ring_push_n(ring_buffer_t *ring, const uint8_t *data, uint32_t n);
+
+/* Copy up to n bytes out. Returns the number of bytes read */
+uint32_t ring_pop_n(ring_buffer_t *ring, uint8_t *data, uint32_t n);
+
+/* Single byte versions. Return 0 on success, -1 if full / empty */
+int ring_push(ring_buffer_t *ring, uint8_t byte);
+int ring_pop(ring_buffer_t *ring, uint8_t *byte);
+
+/* Bytes available to the consumer / free for the producer */
+uint32_t ring_count(const ring_buffer_t *ring);
+uint32_t ring_space(const ring_buffer_t *ring);
+
+/*
+ * Read up to n bytes, blocking the calling task for at most
+ * timeout_ticks ticks (WAIT_FOREVER to wait indefinitely) while the
+ * ring is empty. Returns the number of bytes read, 0 on timeout.
+ */
+uint32_t ring_read(ring_buffer_t *ring, uint8_t *data, uint32_t n, uint32_t timeout_ticks);
+
+#endif /* RING_BUFFER_H */
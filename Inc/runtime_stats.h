@@ -0,0 +1,44 @@
+#ifndef RUNTIME_STATS_H
+#define RUNTIME_STATS_H
+
+#include <stdint.h>
+#include "tasks.h"
+
+/*
+ * Runtime statistics
+ * ------------------
+ * Every context switch charges the outgoing task with the cycles of the
+ * port's free-running counter (TIM5 on Cortex-M, which keeps counting
+ * while the idle task sleeps) since it was switched in.
+ * runtime_stats_sample() reports each task's share of the wall-clock
+ * window since the previous sample and starts a new window. The counter
+ * is 32 bits wide: sample at least every 50 s (84 MHz).
+ *
+ * Enabled with RUNTIME_STATS (tasks.h).
+ */
+
+/* Usage of one task over a window */
+typedef struct {
+    task_handle_t task;         // Task handle (slot 0 = idle)
+    uint8_t  priority;
+    uint16_t cpu_permille;      // Share of the window in 0.1 % units
+    uint32_t switches;          // Times switched in during the window
+    uint64_t cycles;            // Runtime counter cycles during the window
+} task_runtime_t;
+
+/* Totals of a window */
+typedef struct {
+    uint64_t cycles;            // Length of the window (wall clock)
+    uint32_t switches;          // Context switches during the window
+    uint16_t idle_permille;     // Idle task share in 0.1 % units
+} runtime_window_t;
+
+
+/*
+ * Fill up to max_tasks entries for the window since the previous call
+ * (or since scheduler start) and begin a new window.
+ * window may be NULL. Returns the number of entries written.
+ */
+uint32_t runtime_stats_sample(task_runtime_t *tasks, uint32_t max_tasks, runtime_window_t *window);
+
+#endif /* RUNTIME_STATS_H */
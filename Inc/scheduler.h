@@ -2,38 +2,96 @@
 #define SCHEDULER_H
 
 #include <stdint.h>
+#include "tasks.h"
 
-#define MAX_TASKS               10
+/*
+ * Task slots, idle task included. Set at configuration time
+ * (-DMAX_TASKS=n, the KERNEL_MAX_TASKS CMake cache variable).
+ * Nothing on the tick, selection or switch path scales with it.
+ */
+#ifndef MAX_TASKS
+#define MAX_TASKS               256
+#endif
 
 #define TICK_HZ                 1000U
-#define HSI_CLK_FREQ            16000000U   // 16 MHz
-#define SYSTICK_TIM_CLK         HSI_CLK_FREQ
+
+/*
+ * Tickless idle: while only the idle task is runnable, SysTick is
+ * reprogrammed to fire at the next wake-up and the core sleeps in WFI.
+ * Idle periods shorter than TICKLESS_MIN_IDLE_TICKS keep the normal tick.
+ */
+#ifndef TICKLESS_IDLE
+#define TICKLESS_IDLE           1
+#endif
+#define TICKLESS_MIN_IDLE_TICKS 2U
+
+
+/* Timeout for object waits that never expire */
+#define WAIT_FOREVER            UINT32_MAX
+
+/* Object wait results (TCB_t.wait_status) */
+#define WAIT_OK                 0
+#define WAIT_TIMEOUT            (-1)
 
 
 typedef enum{
     SCHED_RR,
     SCHED_PRIORITY,
+    SCHED_EDF,              // Earliest deadline first (task_set_deadline())
 }sched_algo_t;
 
+/* Tick statistics */
+typedef struct {
+    uint32_t switched;      // ticks that requested a context switch
+    uint32_t skipped;       // ticks where the running task stayed selected
+} sched_tick_stats_t;
+
 /* Scheduler core */
 void schedule(void);
 void scheduler_start(void);
 
 
 /* Tick handling */
+void scheduler_tick(void);
 void update_global_tick_count(void);
 void unblock_tasks(void);
 void init_systick_timer(uint32_t tick_hz);
+void scheduler_tick_stats(sched_tick_stats_t *stats);
+
+/* Runtime accounting support */
+void scheduler_runtime_sync(void);
+uint32_t scheduler_runtime_window(void);
+
+/* Idle support */
+void scheduler_idle_sleep(void);
 
 /* Task services */
 void task_delay(uint32_t tick_count);
+void task_delay_until(uint32_t *last_wake, uint32_t period_ticks);
+void task_yield(void);
 
 /* PendSV support */
-void save_psp_value(uint32_t current_psp_val);
+void save_psp_value(uintptr_t current_psp_val);
 void update_next_task(void);
-uint32_t get_psp_value(void);
+uint16_t scheduler_select_next_task(void);
+uintptr_t get_psp_value(void);
+
+int task_set_priority(task_handle_t task, task_priority_t task_priority);
+int task_set_time_slice(task_handle_t task, uint32_t time_slice_ticks);
+int task_set_deadline(task_handle_t task, uint32_t period_ticks, uint32_t deadline_ticks);
+
+/* Switch scheduling policy; requeues the ready tasks */
+void scheduler_set_policy(sched_algo_t algo);
+
+/* Wake-up and preemption (inside CRITICAL_ENTER()) */
+void scheduler_make_ready(TCB_t *tcb);
+void scheduler_preempt_check(void);
 
-void task_set_priority(uint8_t task, task_priority_t task_priority);
+/* Kernel object support (inside CRITICAL_ENTER()) */
+TCB_t *scheduler_current_tcb(void);
+void scheduler_block_current(list_t *wait_list, uint32_t timeout_ticks);
+void scheduler_wake(TCB_t *tcb, int8_t status);
+void scheduler_set_priority(TCB_t *tcb, uint8_t priority);
 
 
 
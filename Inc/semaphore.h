@@ -0,0 +1,44 @@
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include <stdint.h>
+#include "list.h"
+
+/*
+ * Semaphore
+ * ---------
+ * Counting semaphore; a binary semaphore is one with max_count 1.
+ * Blocked takers wait in priority order (FIFO among equal priorities),
+ * so a give wakes the best waiter from the head of the list in O(1).
+ * A give with waiters hands the unit straight to the woken task, so a
+ * task that arrives later cannot take it first.
+ *
+ * sem_give() and sem_take() with a timeout of 0 may be called from
+ * interrupt handlers. Blocking takes are for tasks only (not the idle
+ * task).
+ */
+
+typedef struct {
+    uint32_t count;             // Available units
+    uint32_t max_count;         // Upper limit for count
+    list_t waiters;             // Blocked takers, highest priority first
+} semaphore_t;
+
+
+/* Returns -1 if max_count is 0 or initial_count exceeds it */
+int sem_init(semaphore_t *sem, uint32_t initial_count, uint32_t max_count);
+
+/*
+ * Take one unit, waiting at most timeout_ticks ticks (WAIT_FOREVER to
+ * wait indefinitely, 0 to not wait at all).
+ * Returns 0 on success, -1 on timeout.
+ */
+int sem_take(semaphore_t *sem, uint32_t timeout_ticks);
+
+/* Give one unit. Returns -1 if the count is already at max_count */
+int sem_give(semaphore_t *sem);
+
+/* Units currently available */
+uint32_t sem_count(const semaphore_t *sem);
+
+#endif /* SEMAPHORE_H */
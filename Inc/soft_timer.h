@@ -0,0 +1,64 @@
+#ifndef SOFT_TIMER_H
+#define SOFT_TIMER_H
+
+#include <stdint.h>
+#include "tasks.h"
+
+/*
+ * Software timers
+ * ---------------
+ * One-shot and auto-reload timers whose callbacks run in a single
+ * timer-service task instead of one task (and stack) per periodic job.
+ * Running timers are kept in a binary min-heap keyed on their expiry
+ * tick, so the tick only compares the heap head with g_tick_count and
+ * wakes the service task when it is due; starting or stopping a timer
+ * is O(log n).
+ *
+ * Callbacks run in the service task one after another, so they should
+ * be short and must not block. They may start or stop any timer,
+ * including their own. soft_timer_start() and soft_timer_stop() may
+ * also be called from interrupt handlers.
+ */
+
+/* Running timers the heap can hold */
+#ifndef SOFT_TIMER_MAX
+#define SOFT_TIMER_MAX          32
+#endif
+
+typedef void (*soft_timer_fn_t)(void *arg);
+
+typedef struct {
+    uint32_t expiry;            // Absolute tick of the next expiry
+    uint32_t period;            // Reload in ticks, 0 for a one-shot timer
+    soft_timer_fn_t callback;
+    void *arg;
+    int16_t heap_index;         // Slot in the timer heap, -1 while stopped
+} soft_timer_t;
+
+
+/* Create the timer-service task. Returns -1 if the task cannot be created */
+int soft_timer_service_start(uint32_t stack_size, task_priority_t priority);
+
+/* Set up a stopped timer */
+void soft_timer_init(soft_timer_t *timer, soft_timer_fn_t callback, void *arg);
+
+/*
+ * Start (or restart) a timer: it expires delay_ticks from now and then,
+ * if period_ticks is not 0, every period_ticks after that.
+ * Returns -1 if all SOFT_TIMER_MAX heap slots are in use.
+ */
+int soft_timer_start(soft_timer_t *timer, uint32_t delay_ticks, uint32_t period_ticks);
+
+/* Stop a timer. Returns -1 if it was not running */
+int soft_timer_stop(soft_timer_t *timer);
+
+/* Non-zero while the timer is running */
+int soft_timer_active(const soft_timer_t *timer);
+
+/* Tick hook (inside a kernel critical section): wakes the service task when the head is due */
+void soft_timer_tick(void);
+
+/* Ticks until the earliest timer expires, UINT32_MAX if none runs (tickless idle) */
+uint32_t soft_timer_ticks_until_next(void);
+
+#endif /* SOFT_TIMER_H */
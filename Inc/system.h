@@ -0,0 +1,30 @@
+#ifndef SYSTEM_H
+#define SYSTEM_H
+
+#include <stdint.h>
+
+/*
+ * Clock setup
+ * -----------
+ * SystemInit() (called from Reset_Handler) starts the 8 MHz HSE crystal
+ * of the STM32F4 Discovery and the main PLL, and runs the core at
+ * SYSTEM_CORE_CLOCK_HZ with 5 flash wait states and the ART accelerator
+ * (prefetch, instruction and data caches) enabled. APB1 runs at a
+ * quarter and APB2 at half of the core clock, PLL48CK at 48 MHz.
+ *
+ * If the HSE does not start the PLL runs from the HSI instead, and if
+ * the PLL does not lock the core stays on the 16 MHz HSI. Code that
+ * depends on the clock therefore asks system_core_clock() rather than
+ * assuming SYSTEM_CORE_CLOCK_HZ.
+ */
+
+#define HSI_VALUE               16000000U   // Internal RC oscillator
+#define HSE_VALUE               8000000U    // Discovery board crystal
+#define SYSTEM_CORE_CLOCK_HZ    168000000U  // Target core clock
+
+void SystemInit(void);
+
+/* Current core (HCLK) frequency in Hz, read back from the RCC */
+uint32_t system_core_clock(void);
+
+#endif /* SYSTEM_H */
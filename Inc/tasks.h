@@ -2,57 +2,163 @@
 #define TASKS_H
 
 #include <stdint.h>
-#define RTOS_HEAP_SIZE  (8 * 1024)   // 8 KB total heap
+#include "list.h"
+
+/*
+ * Task stack heap. Stacks are at least 128 bytes, so this, not
+ * MAX_TASKS, bounds the number of live tasks: the default holds 256
+ * minimum-size stacks. It shares the 64 KB CCM with the TCBs.
+ */
+#ifndef RTOS_HEAP_SIZE
+#define RTOS_HEAP_SIZE  (32 * 1024)  // 32 KB total heap
+#endif
+
+/* Message block pool (msg_pool, block_pool.h), allocated next to the heap */
+#define MSG_POOL_BLOCK_SIZE     256U    // Bytes per block (one sensor frame)
+#define MSG_POOL_BLOCK_COUNT    8U
+
+/* Per-task CPU runtime accounting (see runtime_stats.h) */
+#ifndef RUNTIME_STATS
+#define RUNTIME_STATS   1
+#endif
+
+/* Number of numeric priority levels (0 = highest, one bit each in the ready bitmap) */
+#define TASK_PRIORITY_LEVELS    32U
+
+
+/*
+ * Round-robin time slice, in ticks: how long a task keeps the CPU before
+ * the next READY task of the same priority (or, under SCHED_RR, the next
+ * task) gets its turn. Per task, see task_create_sliced() and
+ * task_set_time_slice().
+ */
+#ifndef TASK_TIME_SLICE_DEFAULT
+#define TASK_TIME_SLICE_DEFAULT 1U
+#endif
+#define TASK_TIME_SLICE_MAX     255U
 
 
 /* Task function type */
 typedef void (*task_func_t)(void *);
 
 
+/*
+ * Task handle
+ * Opaque reference to a task: generation << 16 | slot. A handle goes
+ * stale when its task is deleted, even if the slot is reused, so it can
+ * be checked instead of silently addressing another task. Valid handles
+ * are positive; -1 (TASK_HANDLE_INVALID) reports errors.
+ */
+typedef int32_t task_handle_t;
+
+#define TASK_HANDLE_INVALID     ((task_handle_t)-1)
+#define TASK_GENERATION_MAX     0x7FFFU
+
+
 /* Task states */
 typedef enum {
     TASK_STATE_UNUSED = 0,
     TASK_STATE_READY,
-    TASK_STATE_BLOCKED,
+    TASK_STATE_BLOCKED,         // Delayed (task_delay)
+    TASK_STATE_BLOCKED_OBJ,     // Waiting on a kernel object, optionally with a timeout
     TASK_STATE_RUNNING
 } task_state_t;
 
 
-/* Task priorities */
+/*
+ * Task priorities
+ * Named levels for convenience. Any value from 0 (highest) to
+ * TASK_PRIORITY_LEVELS - 1 (idle, lowest) is a valid priority.
+ */
 typedef enum{
     TASK_PRIORITY_HIGH = 0,
-    TASK_PRIORITY_MEDIUM,
-    TASK_PRIORITY_LOW,
-    TASK_PRIORITY_IDLE
+    TASK_PRIORITY_MEDIUM = 8,
+    TASK_PRIORITY_LOW = 16,
+    TASK_PRIORITY_IDLE = TASK_PRIORITY_LEVELS - 1
 }task_priority_t;
 
 
-/* Task Control Block  */
+struct mutex;
+
+/*
+ * Task Control Block
+ * Only the fields used by scheduling, switching and blocking live here,
+ * packed so a switch touches as few cache lines / bus beats as possible.
+ * The pool is placed in core-coupled RAM (PORT_FAST_BSS). Fields used
+ * only at creation, deletion and stats sampling are in TCB_cold_t.
+ */
 typedef struct {
     uint32_t *psp;              // Saved PSP
-    uint32_t block_count;       // Tick to unblock (for delay)
+    uint8_t state;              // task_state_t
+    uint8_t priority;           // 0 (highest) .. TASK_PRIORITY_LEVELS - 1
+    uint8_t base_priority;      // Assigned priority, before inheritance
+    uint8_t ready_level;        // Ready list the task is queued on (ready_queue.c)
 
-    uint8_t  *stack_base;       // Stack memory start
-    uint32_t  stack_size;       // Stack size in bytes
+    list_node_t state_node;     // Link in a ready list or the delay list
+    uint32_t block_count;       // Tick to unblock (for delay)
+    uint32_t deadline;          // Absolute deadline tick of the current job (SCHED_EDF)
+    uint8_t *stack_base;        // Stack memory start (MPU guard, moved on every switch)
+
+    list_node_t event_node;     // Link in a kernel object's wait list
+    list_t *wait_list;          // Wait list the task is queued on, if any
+    uint32_t wait_value;        // Object specific wait data (e.g. event bits)
+    void *wait_data;            // Object specific pointer (e.g. message handed over)
+    int8_t wait_status;         // Result of the last object wait (WAIT_OK / WAIT_TIMEOUT)
+    uint8_t wait_flags;         // Object specific wait options
+    uint16_t generation;        // Bumped on delete, part of the task handle
+    uint32_t notify_value;      // Direct-to-task notification word
+    uint8_t notify_state;       // NOTIFY_STATE_* (notify.h)
+    uint8_t time_slice;         // Ticks per round-robin turn
+    uint8_t slice_left;         // Ticks left in the current turn
+    uint8_t has_deadline;       // Periodic task with a deadline (task_set_deadline())
+
+    list_t mutexes_held;        // Mutexes owned by this task
+    struct mutex *wait_mutex;   // Mutex the task is blocked on, if any
+
+#if RUNTIME_STATS
+    uint64_t run_cycles;        // Runtime counter cycles spent running
+    uint32_t switch_count;      // Times switched in
+#endif
+} TCB_t;
 
-    task_state_t state;
-    task_priority_t priority;
 
+/* Cold half of a task, same index as its TCB_t; stays in normal SRAM */
+typedef struct {
     task_func_t entry;          // Task entry function
     void *arg;                  // Argument to task
-} TCB_t;
+    uint32_t stack_size;        // Stack size in bytes
+    uint32_t period;            // Declared period in ticks (task_set_deadline())
+    uint32_t rel_deadline;      // Deadline relative to each release, in ticks
+
+#if RUNTIME_STATS
+    uint64_t run_cycles_mark;   // run_cycles at the start of the stats window
+    uint32_t switch_count_mark; // switch_count at the start of the stats window
+#endif
+} TCB_cold_t;
 
+extern TCB_cold_t tcb_cold[];
 
 
 
 
-int task_create(
+
+/* Returns the new task's handle, or TASK_HANDLE_INVALID */
+task_handle_t task_create(
     void (*task_fn)(void *),   // WHAT runs
     void *arg,                 // WITH what data
     uint32_t stack_size_bytes, // HOW MUCH stack
     task_priority_t priority   // HOW important
 );
 
+/* task_create() with a time slice other than TASK_TIME_SLICE_DEFAULT */
+task_handle_t task_create_sliced(
+    void (*task_fn)(void *),
+    void *arg,
+    uint32_t stack_size_bytes,
+    task_priority_t priority,
+    uint32_t time_slice_ticks  // 1 .. TASK_TIME_SLICE_MAX
+);
+
 int task_create_idle(
     void (*task_fn)(void *),   // WHAT runs (idle task)
     void *arg,                 // WITH what data
@@ -61,4 +167,14 @@ int task_create_idle(
 
 void task_init(void);
 
+int task_delete(task_handle_t task);
+void task_exit(void);
+
+/* Handle of the calling task */
+task_handle_t task_self(void);
+
+/* TCB of a live task, NULL if the handle is stale or invalid */
+TCB_t *task_from_handle(task_handle_t task);
+task_handle_t task_handle_of(const TCB_t *tcb);
+
 #endif
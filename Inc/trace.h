@@ -0,0 +1,101 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "port.h"
+
+/*
+ * Scheduler event trace
+ * ---------------------
+ * With TRACE_ENABLE, the kernel records compact timestamped events
+ * (switch in/out, ready, block with its reason, create, delete and ISR
+ * entry/exit) into trace_buffer, a RAM ring that always holds the most
+ * recent TRACE_BUFFER_EVENTS events. Dump it from the debugger:
+ *
+ *   (gdb) dump binary value trace.bin trace_buffer
+ *
+ * and convert it with Tools/trace_export.py into Chrome trace JSON for
+ * Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *
+ * A slot is claimed with an atomic increment, so events may be recorded
+ * from any context, nested interrupts included. Timestamps come from
+ * the port's runtime counter (TIM5 on Cortex-M). Without
+ * TRACE_ENABLE the hooks compile to nothing and no buffer is allocated.
+ *
+ * Interrupt handlers are traced by bracketing them with
+ * TRACE_ISR_ENTER(irq) / TRACE_ISR_EXIT(irq), irq being the exception
+ * number (SysTick is 15).
+ */
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE            0
+#endif
+
+#define TRACE_BUFFER_EVENTS     1024U   // Power of two, 8 bytes each
+#define TRACE_MAGIC             0x45435254U     // "TRCE"
+
+/* trace_event_t.type */
+#define TRACE_EVT_SWITCH_IN     1U      // id: task slot
+#define TRACE_EVT_SWITCH_OUT    2U      // id: task slot, arg: task_state_t after the switch
+#define TRACE_EVT_READY         3U      // id: task slot
+#define TRACE_EVT_BLOCK         4U      // id: task slot, arg: TRACE_BLOCK_*
+#define TRACE_EVT_CREATE        5U      // id: task slot, arg: priority
+#define TRACE_EVT_DELETE        6U      // id: task slot
+#define TRACE_EVT_ISR_ENTER     7U      // id: exception number
+#define TRACE_EVT_ISR_EXIT      8U      // id: exception number
+
+/* TRACE_EVT_BLOCK reasons */
+#define TRACE_BLOCK_DELAY       0U      // task_delay()
+#define TRACE_BLOCK_OBJECT      1U      // Kernel object wait list (mutex, semaphore, queue, ...)
+#define TRACE_BLOCK_SIGNAL      2U      // Direct wait without a list (notification, timer service)
+
+typedef struct {
+    uint32_t timestamp;         // Runtime counter
+    uint8_t type;               // TRACE_EVT_*
+    uint8_t arg;
+    uint16_t id;                // Task slot or exception number
+} trace_event_t;
+
+typedef struct {
+    uint32_t magic;             // TRACE_MAGIC
+    uint32_t counter_hz;        // Runtime counter frequency
+    uint32_t capacity;          // TRACE_BUFFER_EVENTS
+    uint32_t head;              // Events recorded so far (next slot = head % capacity)
+    trace_event_t events[TRACE_BUFFER_EVENTS];
+} trace_buffer_t;
+
+
+#if TRACE_ENABLE
+
+extern trace_buffer_t trace_buffer;
+
+/* Clear the buffer and start the timestamp counter (task_init()) */
+void trace_init(void);
+
+/*
+ * The slot is claimed before the timestamp is read, so an interrupt
+ * nesting in between may store a later slot with an earlier timestamp;
+ * Tools/trace_export.py orders events by time.
+ */
+static inline void trace_record(uint8_t type, uint16_t id, uint8_t arg){
+    uint32_t index = __atomic_fetch_add(&trace_buffer.head, 1U, __ATOMIC_RELAXED);
+    trace_event_t *event = &trace_buffer.events[index & (TRACE_BUFFER_EVENTS - 1U)];
+
+    event->timestamp = port_runtime_counter();
+    event->type = type;
+    event->arg = arg;
+    event->id = id;
+}
+
+#define TRACE_EVENT(type, id, arg)  trace_record((type), (uint16_t)(id), (uint8_t)(arg))
+
+#else
+
+#define TRACE_EVENT(type, id, arg)  ((void)0)
+
+#endif /* TRACE_ENABLE */
+
+#define TRACE_ISR_ENTER(irq)        TRACE_EVENT(TRACE_EVT_ISR_ENTER, (irq), 0U)
+#define TRACE_ISR_EXIT(irq)         TRACE_EVENT(TRACE_EVT_ISR_EXIT, (irq), 0U)
+
+#endif /* TRACE_H */
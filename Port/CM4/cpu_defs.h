@@ -0,0 +1,100 @@
+#ifndef CPU_DEFS_H
+#define CPU_DEFS_H
+
+#include <stdint.h>
+
+#define DUMMY_XPSR  0x01000000U  // sets T-bit in EPSR
+
+
+/*
+ * Interrupt priorities: 4 implemented bits on the STM32F4, 0 is the most
+ * urgent. PendSV and SysTick run at PORT_KERNEL_PRIORITY, the lowest.
+ *
+ * Kernel critical sections raise BASEPRI to KERNEL_MAX_SYSCALL_PRIORITY
+ * instead of setting PRIMASK. Interrupts at that priority or a less
+ * urgent one are held off and may use the kernel's ISR functions; more
+ * urgent interrupts are never delayed by the kernel but must not call
+ * into it. Note that the NVIC resets every interrupt to priority 0, so
+ * an ISR that uses the kernel needs its priority lowered first.
+ */
+#define PORT_PRIORITY_BITS          4       // plain literals: PendSV uses them in assembly
+#define PORT_KERNEL_PRIORITY        ((1U << PORT_PRIORITY_BITS) - 1U)
+
+#ifndef KERNEL_MAX_SYSCALL_PRIORITY
+#define KERNEL_MAX_SYSCALL_PRIORITY 5
+#endif
+
+/* Priority level as written to NVIC_IPR / SHPR / BASEPRI (top bits of a byte) */
+#define PORT_PRIORITY_REG(prio)     (((uint32_t)(prio) << (8U - PORT_PRIORITY_BITS)) & 0xFFU)
+
+/* The same for assembly operands: "#" PORT_ASM_SYSCALL_BASEPRI */
+#define PORT_ASM_STR(x)             #x
+#define PORT_ASM_XSTR(x)            PORT_ASM_STR(x)
+#define PORT_ASM_SYSCALL_BASEPRI    "(" PORT_ASM_XSTR(KERNEL_MAX_SYSCALL_PRIORITY) " << (8 - " PORT_ASM_XSTR(PORT_PRIORITY_BITS) "))"
+
+_Static_assert(KERNEL_MAX_SYSCALL_PRIORITY > 0 && KERNEL_MAX_SYSCALL_PRIORITY <= PORT_KERNEL_PRIORITY,
+               "BASEPRI 0 masks nothing, and PendSV/SysTick must be maskable");
+
+/* Interrupt control: PRIMASK, masks everything. Only for startup and the idle sleep */
+#define INTERRUPT_DISABLE()    __asm volatile("CPSID I" ::: "memory")
+#define INTERRUPT_ENABLE()     __asm volatile("CPSIE I" ::: "memory")
+
+/*
+ * Nestable kernel critical sections. Only the outermost CRITICAL_EXIT()
+ * lowers BASEPRI again, so kernel functions may be called with a
+ * critical section held. A context switch requested inside one (PendSV
+ * is masked) happens at that outermost exit: a task must not block
+ * while it holds a critical section of its own.
+ *
+ * One count serves tasks and ISRs: no task switch or maskable interrupt
+ * can come between an enter and its exit, so it is always 0 when a task
+ * is switched and when an interrupt that may use the kernel starts.
+ */
+extern volatile uint32_t port_critical_nesting;
+
+static inline void port_critical_enter(void){
+    __asm volatile("MSR BASEPRI, %0 \n ISB" :: "r"(PORT_PRIORITY_REG(KERNEL_MAX_SYSCALL_PRIORITY)) : "memory");
+    port_critical_nesting++;
+}
+
+static inline void port_critical_exit(void){
+    if (--port_critical_nesting == 0U){
+        __asm volatile("MSR BASEPRI, %0" :: "r"(0U) : "memory");
+    }
+}
+
+#define CRITICAL_ENTER()       port_critical_enter()
+#define CRITICAL_EXIT()        port_critical_exit()
+
+/* Exception return value */
+#define EXC_RETURN_THREAD_PSP_NOFP   0xFFFFFFFD
+#define EXC_RETURN_THREAD_PSP_FP     0xFFFFFFED  // bit 4 clear: extended (FP) frame
+
+/*
+ * Core-coupled RAM (64 KB at 0x10000000, zero wait states, CPU data bus
+ * only). Kernel hot data and task stacks go there so they do not compete
+ * with DMA for the SRAM bus matrix ports. The DMA controllers cannot
+ * reach CCM: DMA buffers must not live on task stacks.
+ *   PORT_FAST_DATA  initialised data (.ccmram, copied by the startup code)
+ *   PORT_FAST_BSS   zero-initialised data (.ccmbss, cleared by the startup code)
+ */
+#define PORT_FAST_DATA  __attribute__((section(".ccmram")))
+#define PORT_FAST_BSS   __attribute__((section(".ccmbss")))
+
+/*
+ * MPU stack guard: a no-access region over the lowest bytes of the
+ * running task's stack, moved on every context switch. Stacks are
+ * allocated aligned to at least this size.
+ */
+#define PORT_STACK_GUARD_LOG2       5U      // 32 bytes
+#define PORT_STACK_GUARD_SIZE       (1U << PORT_STACK_GUARD_LOG2)
+#define PORT_STACK_GUARD_REGION     0U      // MPU region number
+
+/* Hard-float build: PendSV saves S16-S31 for tasks with FP state */
+#if defined(__ARM_FP) && !defined(__SOFTFP__)
+#define PORT_HAS_FPU    1
+#else
+#define PORT_HAS_FPU    0
+#endif
+
+#endif
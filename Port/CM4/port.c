@@ -0,0 +1,454 @@
+#include "cpu_defs.h"
+#include "regs.h"
+#include "system.h"
+#include "scheduler.h"
+#include "port.h"
+#include "log.h"
+#include "trace.h"
+
+/*
+ * Cortex-M4 port
+ * --------------
+ * Tasks run in thread mode on PSP, the kernel and ISRs on MSP.
+ * SysTick drives the tick and PendSV performs the context switch.
+ */
+
+/* SysTick counts per tick, set by init_systick_timer() */
+static uint32_t systick_cycles_per_tick = 0;
+
+/* CRITICAL_ENTER() depth, see cpu_defs.h */
+volatile uint32_t port_critical_nesting = 0;
+
+
+uint32_t *port_init_stack(uint8_t *stack_base, uint32_t stack_size, task_func_t entry, void *arg){
+    uint32_t *pPSP = (uint32_t *) (stack_base + stack_size);
+
+    /* 8-byte alignment (ABI requiremnt) */
+    pPSP = (uint32_t *) ((uint32_t)pPSP & ~0x7);
+
+    /* Cortex-M uses a full-descending stack so we first need to decrement the pointer the updates the value */
+
+    *(--pPSP) = DUMMY_XPSR;                     // xPSR
+    *(--pPSP) = ((uint32_t)entry) | 1;          // PC
+    *(--pPSP) = (uint32_t)task_exit;            // LR: a returning task exits
+    *(--pPSP) = 0;                              // R12
+    *(--pPSP) = 0;                              // R3
+    *(--pPSP) = 0;                              // R2
+    *(--pPSP) = 0;                              // R1
+    *(--pPSP) = (uint32_t)arg;                  // R0 (argument)
+
+    /* Software frame restored by PendSV: a new task has no FP state */
+    *(--pPSP) = EXC_RETURN_THREAD_PSP_NOFP;     // EXC_RETURN
+
+    for (int i = 0; i < 8; i++){
+        *(--pPSP) = 0;                          // R4-R11
+    }
+
+    return pPSP;
+    
+}
+
+
+void port_release_context(uint32_t *psp){
+    /* The context lives on the task's stack, which the kernel reclaims */
+    (void)psp;
+}
+
+
+/* ------------------------------------------------------------
+ * MPU stack guard
+ * ------------------------------------------------------------ */
+
+/*
+ * Point the guard region at the bottom of the running task's stack.
+ * Called by PendSV after update_next_task(); the region attributes
+ * never change, so a switch costs one RBAR write.
+ */
+void port_stack_guard_switch(void){
+    MPU_RBAR = (uint32_t)scheduler_current_tcb()->stack_base | MPU_RBAR_VALID | PORT_STACK_GUARD_REGION;
+}
+
+
+/*
+ * Set up the guard region for the first task and enable the MPU. The
+ * privileged default memory map stays in effect everywhere else, so
+ * only the guard is restricted. Does nothing on a part without an MPU.
+ */
+void port_stack_guard_init(void){
+    if (!(MPU_TYPE & MPU_TYPE_DREGION_Msk)){
+        return;
+    }
+
+    MPU_RNR = PORT_STACK_GUARD_REGION;
+    MPU_RBAR = (uint32_t)scheduler_current_tcb()->stack_base;
+    MPU_RASR = MPU_RASR_XN | MPU_RASR_AP_NONE | MPU_RASR_SIZE(PORT_STACK_GUARD_LOG2) | MPU_RASR_ENABLE;
+    MPU_CTRL = MPU_CTRL_PRIVDEFENA | MPU_CTRL_ENABLE;
+
+    __asm volatile("DSB");
+    __asm volatile("ISB");
+}
+
+
+/*
+ * PendSV and SysTick at the lowest priority, so every other interrupt
+ * preempts them and kernel critical sections can mask them with BASEPRI.
+ */
+void port_kernel_priority_init(void){
+    SCB_SHPR3 = (SCB_SHPR3 & 0x0000FFFFU) |
+                (PORT_PRIORITY_REG(PORT_KERNEL_PRIORITY) << 16) |   // PendSV
+                (PORT_PRIORITY_REG(PORT_KERNEL_PRIORITY) << 24);    // SysTick
+}
+
+
+__attribute__((naked)) void port_start_first_task(void){
+
+    __asm volatile(
+        /* Kernel exception priorities, guard the first task's stack */
+        "BL    port_kernel_priority_init \n"
+        "BL    port_stack_guard_init \n"
+
+        /* Get PSP of the task picked by update_next_task() */
+        "BL    get_psp_value    \n"
+
+        /* Restore software context (R4-R11, EXC_RETURN) */
+        "LDMIA R0!, {R4-R11, LR} \n"
+
+        /* Load PSP of selected task and switch to PSP (clears FPCA) */
+        "MSR   PSP, R0          \n"
+        "MOV   R0, #0x02        \n"
+        "MSR   CONTROL, R0      \n"
+        "ISB                    \n"
+
+        /*
+         * Restore hardware context and jump to task. PC and xPSR are
+         * popped together so the task starts with an 8-byte aligned
+         * stack; R4 and R5 hold no state yet in a fresh frame.
+         */
+        "POP   {R0-R3, R12, LR} \n"
+        "POP   {R4, R5}         \n"
+        "MOV   R5, #0           \n" /* No critical section held */
+        "MSR   BASEPRI, R5      \n"
+        "CPSIE I                \n" /* Enable interrupts */
+        "BX    R4               \n"
+        :
+        :
+        : "memory"
+    );
+}
+
+
+void port_pend_switch(void){
+    /* Request PendSV for context switching */
+    SCB_ICSR = SCB_ICSR_PENDSVSET;
+}
+
+
+/* ------------------------------------------------------------
+ * SysTick ISR
+ * ------------------------------------------------------------ */
+
+/*
+ * SysTick runs at the lowest priority, so the tick processing is a
+ * critical section: ISRs that use the kernel could preempt it otherwise.
+ */
+void SysTick_Handler(void){
+    TRACE_ISR_ENTER(15);
+    CRITICAL_ENTER();
+    scheduler_tick();
+    CRITICAL_EXIT();
+    TRACE_ISR_EXIT(15);
+}
+
+/* ------------------------------------------------------------
+ * PendSV ISR (context switch)
+ * ------------------------------------------------------------ */
+
+/*
+ * PendSV_Handler
+ * ---------------
+ * Performs a context switch between tasks.
+ *
+ * PendSV runs in handler mode using MSP, while tasks run in thread mode using PSP.
+ * This handler saves the context of the current task, selects the next task to run,
+ * restores its context and returns to thread mode.
+ *
+ * Software-saved frame on the task stack (lowest address first):
+ *   R4-R11, EXC_RETURN            always
+ *   S16-S31                       only for tasks with an active FP context
+ *
+ * A task that has used the FPU since its last switch has CONTROL.FPCA set,
+ * so exception entry reserved an extended frame (S0-S15, FPSCR) and
+ * EXC_RETURN bit 4 is 0. Only then are S16-S31 saved; the VSTM also
+ * triggers the lazy hardware stacking of S0-S15. Integer-only tasks keep
+ * the small frame and pay one TST per switch.
+ */
+__attribute__((naked)) void PendSV_Handler(void){
+    __asm volatile(
+        /* ------------------------------------------------------------
+         * Step 1: Save context of the currently running task (PSP)
+         * ------------------------------------------------------------ */
+
+        "MRS   R0, PSP        \n"   // store current running task PSP value into R0
+
+#if PORT_HAS_FPU
+        /* EXC_RETURN bit 4 clear: the task has FP state, save S16-S31 */
+        "TST   LR, #0x10      \n"
+        "IT    EQ             \n"
+        "VSTMDBEQ R0!, {S16-S31} \n"
+#endif
+
+        "STMDB R0!, {R4-R11, LR} \n"   // store R4-R11 and EXC_RETURN onto the stack
+        /*
+         * Save callee-saved registers R4–R11 onto the task stack.
+         * STMDB (Decrement Before) creates space first, then stores.
+         * EXC_RETURN is kept with the task because it records whether
+         * the task's frame holds FP state.
+         *
+         * Effect (conceptual):
+         *   R0 = R0 - 36;              // 9 registers × 4 bytes
+         *   [R0 + 0]  = R4;
+         *   [R0 + 4]  = R5;
+         *   ...
+         *   [R0 + 28] = R11;
+         *   [R0 + 32] = EXC_RETURN;
+         */
+
+        "MSR   PSP, R0        \n"   // update PSP to new top of stack
+
+        /* ------------------------------------------------------------
+         * Step 2: Call scheduler functions (use MSP)
+         * ------------------------------------------------------------ */
+
+        /*
+         * LR is already saved with the task, so MSP stays 8-byte aligned
+         * for the C calls as the AAPCS requires.
+         *
+         * PendSV has the lowest priority: mask the ISRs that may use the
+         * kernel (BASEPRI, as CRITICAL_ENTER() does) while the ready
+         * queue is read. The nesting count is 0 here and stays untouched.
+         */
+        "MOV   R1, #" PORT_ASM_SYSCALL_BASEPRI " \n"
+        "MSR   BASEPRI, R1    \n"
+        "DSB                  \n"
+        "ISB                  \n"
+
+        /* Save PSP of current task, select next task to run and get its PSP */
+        "BL    save_psp_value \n"
+        "BL    update_next_task \n"
+        "BL    port_stack_guard_switch \n"   // guard region to the next task's stack
+        "BL    get_psp_value  \n"
+
+        "MOV   R1, #0         \n"
+        "MSR   BASEPRI, R1    \n"   // kernel-aware ISRs may run again
+
+        /*
+         * Restore callee-saved registers R4–R11 and the task's EXC_RETURN
+         * from the next task's stack. LDMIA (Increment After) reverses the
+         * earlier STMDB.
+         */
+        "LDMIA R0!, {R4-R11, LR} \n"
+
+#if PORT_HAS_FPU
+        "TST   LR, #0x10      \n"
+        "IT    EQ             \n"
+        "VLDMIAEQ R0!, {S16-S31} \n"
+#endif
+
+        /* Update PSP to point above the restored context */
+        "MSR   PSP, R0        \n"
+
+        /* ------------------------------------------------------------
+         * Step 3: Exception return
+         * ------------------------------------------------------------ */
+
+        /*
+         * BX LR triggers exception return using EXC_RETURN.
+         * The CPU automatically restores:
+         *   R0–R3, R12, LR, PC, xPSR (and S0-S15, FPSCR for FP frames)
+         * and resumes execution of the selected task in thread mode.
+         */
+        "BX    LR             \n"
+    );
+}
+
+
+void init_systick_timer(uint32_t tick_hz){
+    uint32_t reload;
+
+    /* Calculate reload value */
+    systick_cycles_per_tick = system_core_clock() / tick_hz;
+    reload = systick_cycles_per_tick - 1U;
+
+    /* Load reload value */
+    SYST_RVR = reload;
+
+    /* Clear current value register */
+    SYST_CVR = 0U;
+
+    /* Configure and start SysTick
+     * - Processor clock
+     * - Enable SysTick interrupt
+     * - Enable SysTick counter
+     */
+    SYST_CSR = SYST_CSR_CLKSOURCE | SYST_CSR_TICKINT  | SYST_CSR_ENABLE;
+}
+
+
+/* ------------------------------------------------------------
+ * Runtime counter
+ * ------------------------------------------------------------ */
+
+/*
+ * TIM5 free-running at the APB1 timer clock (84 MHz), wrapping every
+ * 51 s. Unlike DWT CYCCNT it keeps counting while the core sleeps in
+ * WFI, so tickless idle time is charged to the idle task. Bench/ uses
+ * TIM2, so the two never share a timer.
+ */
+void port_init_runtime_counter(void){
+    /* Not restarted: tracing may have started it already, only differences count */
+    if (TIM5_CR1 & TIM_CR1_CEN){
+        return;
+    }
+
+    RCC_APB1ENR |= RCC_APB1ENR_TIM5EN;
+    TIM5_PSC = 0;
+    TIM5_ARR = 0xFFFFFFFFU;
+    TIM5_EGR = TIM_EGR_UG;      // load the prescaler
+    TIM5_CR1 = TIM_CR1_CEN;
+}
+
+
+uint32_t port_runtime_counter(void){
+    return TIM5_CNT;
+}
+
+
+/* APB1 timers run at twice PCLK1 whenever APB1 is divided */
+uint32_t port_runtime_counter_hz(void){
+    uint32_t ppre1 = (RCC_CFGR & RCC_CFGR_PPRE1_MASK) >> 10;
+    uint32_t hclk = system_core_clock();
+
+    if (ppre1 < 4U){
+        return hclk;                        // not divided
+    }
+    return (hclk >> (ppre1 - 3U)) * 2U;     // PCLK1 = HCLK / 2^(ppre1 - 3)
+}
+
+
+/* ------------------------------------------------------------
+ * Sleep and tickless idle
+ * ------------------------------------------------------------ */
+
+void port_wait_for_interrupt(void){
+    __asm volatile("WFI");
+}
+
+
+/*
+ * Stretches the SysTick period up to the expected wake-up and sleeps in
+ * WFI. Called inside a critical section, whose BASEPRI would also keep
+ * SysTick from waking the core, so PRIMASK takes over for the sleep: a
+ * pending interrupt still wakes the core, but its handler only runs
+ * after the caller has corrected the tick count.
+ */
+uint32_t port_tickless_sleep(uint32_t expected){
+    /* SysTick is 24 bits wide; sleep at most that long, then re-evaluate */
+    uint32_t max_ticks = SYST_RVR_MAX / systick_cycles_per_tick;
+    if (expected > max_ticks){
+        expected = max_ticks;
+    }
+
+    /*
+     * Stop SysTick. CSR is written, not read-modify-written, because a
+     * read clears COUNTFLAG, which tells us below whether the timer expired.
+     */
+    SYST_CSR = SYST_CSR_CLKSOURCE | SYST_CSR_TICKINT;
+
+    /* A tick that fired after interrupts were masked must be handled first */
+    if (SCB_ICSR & SCB_ICSR_PENDSTSET){
+        SYST_CSR = SYST_CSR_CLKSOURCE | SYST_CSR_TICKINT | SYST_CSR_ENABLE;
+        return 0;
+    }
+
+    /* Stretch the current tick period up to the wake-up (writing CVR clears COUNTFLAG) */
+    uint32_t reload = SYST_CVR + (systick_cycles_per_tick * (expected - 1U));
+
+    SYST_RVR = reload;
+    SYST_CVR = 0U;
+    SYST_CSR = SYST_CSR_CLKSOURCE | SYST_CSR_TICKINT | SYST_CSR_ENABLE;
+
+    INTERRUPT_DISABLE();
+    __asm volatile("MSR BASEPRI, %0 \n DSB \n WFI \n ISB" :: "r"(0U) : "memory");
+    __asm volatile("MSR BASEPRI, %0 \n ISB" :: "r"(PORT_PRIORITY_REG(KERNEL_MAX_SYSCALL_PRIORITY)) : "memory");
+    INTERRUPT_ENABLE();
+
+    /* Stop SysTick to read a stable count */
+    SYST_CSR = SYST_CSR_CLKSOURCE | SYST_CSR_TICKINT;
+
+    uint32_t completed;
+
+    if (SYST_CSR & SYST_CSR_COUNTFLAG){
+        /*
+         * Timer expired: the SysTick exception is now pending and will
+         * count the last tick itself. Shorten the next period by the
+         * counts that already elapsed after the expiry.
+         */
+        uint32_t overshoot = reload - SYST_CVR;
+        uint32_t next = systick_cycles_per_tick - 1U;
+
+        if (overshoot < next){
+            next -= overshoot;
+        }
+
+        SYST_RVR = next;
+        completed = expected - 1U;
+    }else{
+        /* Woken early by another interrupt: count only whole ticks */
+        uint32_t elapsed = (expected * systick_cycles_per_tick) - SYST_CVR;
+
+        completed = elapsed / systick_cycles_per_tick;
+        SYST_RVR = ((completed + 1U) * systick_cycles_per_tick) - elapsed;
+    }
+
+    /* Restart; the normal period is reloaded after this partial one */
+    SYST_CVR = 0U;
+    SYST_CSR = SYST_CSR_CLKSOURCE | SYST_CSR_TICKINT | SYST_CSR_ENABLE;
+    SYST_RVR = systick_cycles_per_tick - 1U;
+
+    return completed;
+}
+
+
+/* ------------------------------------------------------------
+ * Deferred log output
+ * ------------------------------------------------------------ */
+
+/*
+ * Sends a record as 32-bit words on ITM stimulus port LOG_ITM_PORT:
+ *
+ *   0xA0 | nargs (top byte), format string ID (.logstr offset, low 24 bits)
+ *   timestamp
+ *   nargs arguments
+ *
+ * Each word is one 4-byte SWIT packet, a quarter of the FIFO waits of
+ * byte-wise printf. Nothing is sent unless a debugger has enabled the
+ * ITM and the port (OpenOCD: "itm port 1 on").
+ */
+void port_log_emit(const char *fmt, uint32_t timestamp, const uint32_t *args, uint32_t nargs){
+    if (!(ITM_TCR & ITM_TCR_ITMENA) || !(ITM_TER & (1U << LOG_ITM_PORT))){
+        return;
+    }
+
+    uint32_t header = 0xA0000000U | (nargs << 24) | ((uint32_t)fmt & 0x00FFFFFFU);
+
+    while (!(ITM_STIM(LOG_ITM_PORT) & ITM_STIM_FIFOREADY));
+    ITM_STIM(LOG_ITM_PORT) = header;
+
+    while (!(ITM_STIM(LOG_ITM_PORT) & ITM_STIM_FIFOREADY));
+    ITM_STIM(LOG_ITM_PORT) = timestamp;
+
+    for (uint32_t i = 0; i < nargs; i++){
+        while (!(ITM_STIM(LOG_ITM_PORT) & ITM_STIM_FIFOREADY));
+        ITM_STIM(LOG_ITM_PORT) = args[i];
+    }
+}
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include "cpu_defs.h"
+#include "led.h"
+
+/*
+ * Board stubs for the POSIX port: LED changes are printed with the
+ * current tick so the demo in Src/main.c can run unchanged.
+ */
+
+extern uint32_t g_tick_count;
+
+/* Simulated GPIOD output bits, for led_toggle() */
+static uint16_t led_state = 0;
+
+
+static const char *led_name(uint8_t led_no){
+    switch (led_no){
+    case LED_GREEN:  return "green";
+    case LED_ORANGE: return "orange";
+    case LED_RED:    return "red";
+    case LED_BLUE:   return "blue";
+    default:         return "?";
+    }
+}
+
+
+static void led_print(uint8_t led_no, const char *state){
+    char line[64];
+
+    CRITICAL_ENTER();
+    int len = snprintf(line, sizeof(line), "%8lu %-6s %s\n",
+                       (unsigned long)g_tick_count, led_name(led_no), state);
+    if (len > 0 && write(STDOUT_FILENO, line, (size_t)len) < 0){
+        /* nothing to do, stdout is gone */
+    }
+    CRITICAL_EXIT();
+}
+
+
+void delay(uint32_t count){
+    for (volatile uint32_t i = 0; i < count; i++);
+}
+
+void led_init_all(void){
+}
+
+void led_on(uint8_t led_no){
+    led_state |= (uint16_t)(1U << led_no);
+    led_print(led_no, "on");
+}
+
+void led_off(uint8_t led_no){
+    led_state &= (uint16_t)~(1U << led_no);
+    led_print(led_no, "off");
+}
+
+void led_toggle(uint8_t led_no){
+    if (led_state & (1U << led_no)){
+        led_off(led_no);
+    }else{
+        led_on(led_no);
+    }
+}
+
+void enable_processor_faults(void){
+}
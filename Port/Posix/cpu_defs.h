@@ -0,0 +1,32 @@
+#ifndef CPU_DEFS_H
+#define CPU_DEFS_H
+
+/*
+ * POSIX port: the tick interrupt is SIGALRM, so "disabling interrupts"
+ * blocks that signal. A context switch requested while it is blocked is
+ * performed when it is unblocked again, like a pended PendSV.
+ */
+void port_posix_interrupt_disable(void);
+void port_posix_interrupt_enable(void);
+void port_posix_critical_enter(void);
+void port_posix_critical_exit(void);
+
+/* Interrupt control */
+#define INTERRUPT_DISABLE()    port_posix_interrupt_disable()
+#define INTERRUPT_ENABLE()     port_posix_interrupt_enable()
+
+/*
+ * Nestable kernel critical sections: SIGALRM is unblocked again by the
+ * outermost exit only. There is no interrupt priority to leave unmasked.
+ */
+#define CRITICAL_ENTER()       port_posix_critical_enter()
+#define CRITICAL_EXIT()        port_posix_critical_exit()
+
+/* No special memory on the host */
+#define PORT_FAST_DATA
+#define PORT_FAST_BSS
+
+/* No stack guard: host stacks are separate allocations */
+#define PORT_STACK_GUARD_SIZE  0U
+
+#endif
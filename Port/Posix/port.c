@@ -0,0 +1,322 @@
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "cpu_defs.h"
+#include "scheduler.h"
+#include "port.h"
+#include "log.h"
+#include "trace.h"
+
+/*
+ * POSIX port
+ * ----------
+ * Runs the kernel as a single Linux process:
+ *   - every task is a ucontext with its own host stack
+ *   - SIGALRM from an interval timer replaces SysTick
+ *   - INTERRUPT_DISABLE()/ENABLE() block/unblock SIGALRM, CRITICAL_ENTER()/
+ *     EXIT() do the same with a nesting count kept per task
+ *   - a pended switch runs when SIGALRM is unblocked or at the end of
+ *     the tick handler, which is where PendSV would run on Cortex-M
+ *
+ * TCB_t.psp holds a pointer to the task's port_context_t. The stack the
+ * kernel allocates from rtos_heap is left unused: host code (libc, printf)
+ * needs far more stack than the target, so each task gets
+ * PORT_POSIX_STACK_SIZE bytes of host stack instead.
+ */
+
+#define PORT_POSIX_STACK_SIZE   (64 * 1024)
+
+typedef struct port_context {
+    ucontext_t  ctx;
+    task_func_t entry;
+    void       *arg;
+    struct port_context *next_free;
+} port_context_t;
+
+
+extern uint16_t current_task;
+extern TCB_t tcb_pool[MAX_TASKS];
+
+static sigset_t tick_sigset;
+
+/* Per-context interrupt state, saved and restored across switches */
+static volatile int interrupts_masked = 0;
+static volatile int in_isr = 0;
+static volatile int switch_pending = 0;
+static volatile unsigned critical_nesting = 0;
+
+/* Contexts of deleted tasks, reused by port_init_stack() */
+static port_context_t *free_contexts = NULL;
+
+
+static port_context_t *context_of(uint16_t task){
+    return (port_context_t *)tcb_pool[task].psp;
+}
+
+
+/*
+ * Switch to the task picked by update_next_task().
+ * Must be called with SIGALRM blocked (or from the SIGALRM handler).
+ */
+static void port_switch(void){
+    port_context_t *from = context_of(current_task);
+
+    update_next_task();
+
+    port_context_t *to = context_of(current_task);
+
+    if (from == to){
+        return;
+    }
+
+    int saved_masked = interrupts_masked;
+    int saved_in_isr = in_isr;
+    unsigned saved_nesting = critical_nesting;
+
+    swapcontext(&from->ctx, &to->ctx);
+
+    /* Switched back to this task */
+    interrupts_masked = saved_masked;
+    in_isr = saved_in_isr;
+    critical_nesting = saved_nesting;
+}
+
+
+void port_posix_interrupt_disable(void){
+    sigprocmask(SIG_BLOCK, &tick_sigset, NULL);
+    interrupts_masked = 1;
+}
+
+
+void port_posix_interrupt_enable(void){
+    /*
+     * Inside the tick handler the signal stays blocked until it returns,
+     * but the flag is cleared like the disable set it; tick_handler()
+     * puts back what the interrupted context had.
+     */
+    if (in_isr){
+        interrupts_masked = 0;
+        return;
+    }
+
+    while (switch_pending){
+        switch_pending = 0;
+        port_switch();
+    }
+
+    interrupts_masked = 0;
+    sigprocmask(SIG_UNBLOCK, &tick_sigset, NULL);
+}
+
+
+void port_posix_critical_enter(void){
+    if (critical_nesting++ == 0U){
+        port_posix_interrupt_disable();
+    }
+}
+
+
+void port_posix_critical_exit(void){
+    if (--critical_nesting == 0U){
+        port_posix_interrupt_enable();
+    }
+}
+
+
+static void task_trampoline(void){
+    port_context_t *ctx = context_of(current_task);
+
+    /* A new task starts with interrupts enabled */
+    interrupts_masked = 0;
+    in_isr = 0;
+    critical_nesting = 0;
+
+    ctx->entry(ctx->arg);
+
+    task_exit();
+}
+
+
+uint32_t *port_init_stack(uint8_t *stack_base, uint32_t stack_size, task_func_t entry, void *arg){
+    port_context_t *ctx = free_contexts;
+    void *stack;
+
+    /* Reuse the context and host stack of a deleted task if there is one */
+    if (ctx){
+        free_contexts = ctx->next_free;
+        stack = ctx->ctx.uc_stack.ss_sp;
+    }else{
+        ctx = malloc(sizeof(*ctx));
+        stack = malloc(PORT_POSIX_STACK_SIZE);
+
+        if (!ctx || !stack){
+            fprintf(stderr, "port: out of host memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    (void)stack_base;
+    (void)stack_size;
+
+    getcontext(&ctx->ctx);
+    ctx->ctx.uc_stack.ss_sp = stack;
+    ctx->ctx.uc_stack.ss_size = PORT_POSIX_STACK_SIZE;
+    ctx->ctx.uc_link = NULL;
+    sigdelset(&ctx->ctx.uc_sigmask, SIGALRM);
+    ctx->entry = entry;
+    ctx->arg = arg;
+
+    makecontext(&ctx->ctx, task_trampoline, 0);
+
+    return (uint32_t *)ctx;
+}
+
+
+void port_release_context(uint32_t *psp){
+    port_context_t *ctx = (port_context_t *)psp;
+
+    /*
+     * Only reused by a later port_init_stack(), which runs in another
+     * task after the deleted one has been switched away from.
+     */
+    ctx->next_free = free_contexts;
+    free_contexts = ctx;
+}
+
+
+static void tick_handler(int sig){
+    int saved_masked = interrupts_masked;
+
+    (void)sig;
+
+    in_isr = 1;
+    TRACE_ISR_ENTER(15);        // reported as SysTick
+    scheduler_tick();
+    TRACE_ISR_EXIT(15);
+    in_isr = 0;
+    interrupts_masked = saved_masked;
+
+    if (switch_pending){
+        switch_pending = 0;
+        port_switch();
+    }
+}
+
+
+void port_start_first_task(void){
+    setcontext(&context_of(current_task)->ctx);
+
+    /* setcontext only returns on error */
+    abort();
+}
+
+
+void port_pend_switch(void){
+    switch_pending = 1;
+
+    /* Like PendSV: taken at once unless masked or already in an ISR */
+    if (!interrupts_masked && !in_isr){
+        port_posix_interrupt_disable();
+        port_posix_interrupt_enable();
+    }
+}
+
+
+void init_systick_timer(uint32_t tick_hz){
+    struct sigaction sa = {0};
+    struct itimerval period = {0};
+
+    sigemptyset(&tick_sigset);
+    sigaddset(&tick_sigset, SIGALRM);
+
+    /* No ticks until the first task runs with SIGALRM unblocked */
+    port_posix_interrupt_disable();
+
+    sa.sa_handler = tick_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGALRM, &sa, NULL);
+
+    period.it_interval.tv_usec = (suseconds_t)(1000000U / tick_hz);
+    period.it_value = period.it_interval;
+    setitimer(ITIMER_REAL, &period, NULL);
+}
+
+
+void port_init_runtime_counter(void){
+}
+
+
+/* Monotonic time in nanoseconds, truncated to 32 bits */
+uint32_t port_runtime_counter(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+
+uint32_t port_runtime_counter_hz(void){
+    return 1000000000U;
+}
+
+
+void port_wait_for_interrupt(void){
+    sigset_t unblocked;
+
+    port_posix_interrupt_disable();
+    sigprocmask(SIG_BLOCK, NULL, &unblocked);
+    sigdelset(&unblocked, SIGALRM);
+
+    if (!switch_pending){
+        sigsuspend(&unblocked);
+    }
+
+    port_posix_interrupt_enable();
+}
+
+
+/*
+ * The interval timer is not reprogrammed: the host sleeps until the next
+ * tick, which the tick handler counts itself.
+ */
+uint32_t port_tickless_sleep(uint32_t expected_ticks){
+    (void)expected_ticks;
+
+    port_posix_interrupt_enable();
+    port_wait_for_interrupt();
+    port_posix_interrupt_disable();
+
+    return 0;
+}
+
+
+/*
+ * Deferred log output: format strings are in memory here, so the record
+ * is printed directly (missing arguments are passed as 0).
+ */
+void port_log_emit(const char *fmt, uint32_t timestamp, const uint32_t *args, uint32_t nargs){
+    uint32_t a[LOG_MAX_ARGS] = {0};
+    char line[160];
+
+    for (uint32_t i = 0; i < nargs && i < LOG_MAX_ARGS; i++){
+        a[i] = args[i];
+    }
+
+    int len = snprintf(line, sizeof(line), "%8lu ", (unsigned long)timestamp);
+    len += snprintf(line + len, sizeof(line) - (size_t)len - 1U, fmt, a[0], a[1], a[2], a[3]);
+    if (len > (int)sizeof(line) - 2){
+        len = (int)sizeof(line) - 2;
+    }
+    line[len++] = '\n';
+
+    if (write(STDOUT_FILENO, line, (size_t)len) < 0){
+        /* nothing to do, stdout is gone */
+    }
+}
@@ -0,0 +1,94 @@
+#include "block_pool.h"
+#include "cpu_defs.h"
+#include "scheduler.h"
+
+
+extern TCB_t tcb_pool[MAX_TASKS];
+
+
+int block_pool_init(block_pool_t *pool, void *storage, uint32_t block_size, uint32_t block_count){
+    /* 8 byte alignment, and room for the free list link */
+    block_size = (block_size + 7) & ~0x7;
+
+    if (!storage || block_size < sizeof(void *) || block_count == 0 ||
+        ((uintptr_t)storage & 0x7)){
+        return -1;
+    }
+
+    pool->block_size = block_size;
+    pool->block_count = block_count;
+    pool->free_count = block_count;
+    pool->start = storage;
+    pool->end = pool->start + block_size * block_count;
+    list_init(&pool->waiters);
+
+    /* Thread the free list through the blocks, lowest address first */
+    pool->free_list = NULL;
+    for (uint32_t i = block_count; i > 0; i--){
+        void **block = (void **)(pool->start + (i - 1) * block_size);
+        *block = pool->free_list;
+        pool->free_list = block;
+    }
+
+    return 0;
+}
+
+
+void *block_alloc(block_pool_t *pool, uint32_t timeout_ticks){
+    CRITICAL_ENTER();
+
+    void **block = pool->free_list;
+    if (block){
+        pool->free_list = *block;
+        pool->free_count--;
+        CRITICAL_EXIT();
+        return block;
+    }
+
+    TCB_t *self = scheduler_current_tcb();
+
+    /* The idle task must never block */
+    if (timeout_ticks == 0 || self == &tcb_pool[0]){
+        CRITICAL_EXIT();
+        return NULL;
+    }
+
+    scheduler_block_current(&pool->waiters, timeout_ticks);
+
+    CRITICAL_EXIT();
+
+    /* Switched out here until block_free() hands us a block or the timeout expires */
+
+    return (self->wait_status == WAIT_OK) ? self->wait_data : NULL;
+}
+
+
+int block_free(block_pool_t *pool, void *block){
+    uint8_t *ptr = block;
+
+    if (ptr < pool->start || ptr >= pool->end ||
+        (uint32_t)(ptr - pool->start) % pool->block_size){
+        return -1;
+    }
+
+    CRITICAL_ENTER();
+
+    /* A waiting task gets the block directly */
+    list_node_t *node = list_first(&pool->waiters);
+    if (node){
+        TCB_t *tcb = LIST_ENTRY(node, TCB_t, event_node);
+
+        tcb->wait_data = block;
+        scheduler_wake(tcb, WAIT_OK);
+        CRITICAL_EXIT();
+        return 0;
+    }
+
+    *(void **)block = pool->free_list;
+    pool->free_list = block;
+    pool->free_count++;
+
+    CRITICAL_EXIT();
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include "event_group.h"
+#include "cpu_defs.h"
+#include "scheduler.h"
+
+
+extern TCB_t tcb_pool[MAX_TASKS];
+
+
+static int condition_met(uint32_t current, uint32_t wanted, uint8_t flags){
+    if (flags & EVENT_WAIT_ALL){
+        return (current & wanted) == wanted;
+    }
+    return (current & wanted) != 0;
+}
+
+
+void event_group_init(event_group_t *group){
+    group->bits = 0;
+    list_init(&group->waiters);
+}
+
+
+uint32_t event_group_set(event_group_t *group, uint32_t bits){
+    CRITICAL_ENTER();
+
+    group->bits |= bits;
+
+    /*
+     * Every waiter sees the bits as set by this call; bits cleared on
+     * exit are removed only after all waiters have been checked, so
+     * tasks waiting for the same event are all released.
+     */
+    uint32_t clear = 0;
+    list_node_t *node = group->waiters.next;
+
+    while (node != &group->waiters){
+        TCB_t *tcb = LIST_ENTRY(node, TCB_t, event_node);
+        node = node->next;
+
+        if (condition_met(group->bits, tcb->wait_value, tcb->wait_flags)){
+            if (tcb->wait_flags & EVENT_CLEAR_ON_EXIT){
+                clear |= tcb->wait_value;
+            }
+            tcb->wait_value = group->bits;
+            scheduler_wake(tcb, WAIT_OK);
+        }
+    }
+
+    group->bits &= ~clear;
+    uint32_t result = group->bits;
+
+    CRITICAL_EXIT();
+
+    return result;
+}
+
+
+uint32_t event_group_clear(event_group_t *group, uint32_t bits){
+    CRITICAL_ENTER();
+
+    uint32_t previous = group->bits;
+    group->bits &= ~bits;
+
+    CRITICAL_EXIT();
+
+    return previous;
+}
+
+
+uint32_t event_group_get(const event_group_t *group){
+    return group->bits;
+}
+
+
+int event_group_wait(event_group_t *group, uint32_t bits, uint8_t flags,
+                     uint32_t timeout_ticks, uint32_t *result){
+    if (!bits){
+        return -1;
+    }
+
+    CRITICAL_ENTER();
+
+    if (condition_met(group->bits, bits, flags)){
+        if (result){
+            *result = group->bits;
+        }
+        if (flags & EVENT_CLEAR_ON_EXIT){
+            group->bits &= ~bits;
+        }
+        CRITICAL_EXIT();
+        return 0;
+    }
+
+    TCB_t *self = scheduler_current_tcb();
+
+    /* The idle task must never block */
+    if (timeout_ticks == 0 || self == &tcb_pool[0]){
+        if (result){
+            *result = group->bits;
+        }
+        CRITICAL_EXIT();
+        return -1;
+    }
+
+    self->wait_value = bits;
+    self->wait_flags = flags;
+    scheduler_block_current(&group->waiters, timeout_ticks);
+
+    CRITICAL_EXIT();
+
+    /* Switched out here until event_group_set() or the timeout wakes us */
+
+    CRITICAL_ENTER();
+
+    int status = self->wait_status;
+    if (result){
+        /* event_group_set() left the bits it saw in wait_value */
+        *result = (status == WAIT_OK) ? self->wait_value : group->bits;
+    }
+
+    CRITICAL_EXIT();
+
+    return (status == WAIT_OK) ? 0 : -1;
+}
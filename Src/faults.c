@@ -1,5 +1,11 @@
 #include <stdio.h>
 #include "regs.h"
+#include "cpu_defs.h"
+#include "tasks.h"
+#include "scheduler.h"
+
+
+extern TCB_t tcb_pool[MAX_TASKS];
 
 void enable_processor_faults(void){
     /*
@@ -20,8 +26,47 @@ void HardFault_Handler(void){
     while (1);
 }
 
+/*
+ * Task whose stack guard region contains addr, or -1.
+ * Only the running task's guard is mapped, but checking all of them
+ * also catches a task overflowing while the guard was switched.
+ */
+static int stack_guard_owner(uint32_t addr){
+    for (int i = 0; i < MAX_TASKS; i++){
+        uint32_t base = (uint32_t)tcb_pool[i].stack_base;
+
+        if (tcb_pool[i].state != TASK_STATE_UNUSED &&
+            addr - base < PORT_STACK_GUARD_SIZE){
+            return i;
+        }
+    }
+    return -1;
+}
+
 void MemManage_Handler(void){
-    printf("Exception: Memory Management Fault\n");
+    uint32_t mmfsr = SCB_CFSR & SCB_CFSR_MMFSR_MASK;
+    uint32_t addr = SCB_MMFAR;
+    int task = -1;
+
+    /*
+     * A stack overflow hits the guard region either from task code
+     * (DACCVIOL, MMFAR valid) or while the exception frame is pushed
+     * (MSTKERR, no address), which can only be the running task.
+     */
+    if ((mmfsr & SCB_CFSR_MMARVALID) && (mmfsr & SCB_CFSR_DACCVIOL)){
+        task = stack_guard_owner(addr);
+    }else if (mmfsr & (SCB_CFSR_MSTKERR | SCB_CFSR_MLSPERR)){
+        task = (int)(scheduler_current_tcb() - tcb_pool);
+    }
+
+    if (task >= 0){
+        printf("Exception: Memory Management Fault: stack overflow in task %d, handle 0x%08lx (stack %p, %lu bytes)\n",
+               task, (unsigned long)task_handle_of(&tcb_pool[task]),
+               (void *)tcb_pool[task].stack_base, (unsigned long)tcb_cold[task].stack_size);
+    }else{
+        printf("Exception: Memory Management Fault (MMFSR 0x%02lx, address 0x%08lx)\n",
+               (unsigned long)mmfsr, (unsigned long)addr);
+    }
     while (1);
 }
 
@@ -49,4 +49,10 @@ void led_off(uint8_t led_no)
 	  uint32_t *pGpiodDataReg = (uint32_t*)0x40020C14;
 	  *pGpiodDataReg &= ~( 1 << led_no);
 
-}
\ No newline at end of file
+}
+void led_toggle(uint8_t led_no)
+{
+	  uint32_t *pGpiodDataReg = (uint32_t*)0x40020C14;
+	  *pGpiodDataReg ^= ( 1 << led_no);
+
+}
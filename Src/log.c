@@ -0,0 +1,96 @@
+#include "log.h"
+#include "cpu_defs.h"
+#include "scheduler.h"
+#include "port.h"
+
+
+extern uint32_t g_tick_count;
+
+#define LOG_RING_MASK   (LOG_RING_RECORDS - 1U)
+
+_Static_assert((LOG_RING_RECORDS & LOG_RING_MASK) == 0, "LOG_RING_RECORDS must be a power of two");
+
+static log_record_t log_ring[LOG_RING_RECORDS];
+
+/* Next slot to claim (producers) and next record to emit (drain) */
+static uint32_t log_head = 0;
+static uint32_t log_tail = 0;
+
+/* Records lost because the ring was full */
+static uint32_t log_dropped = 0;
+
+static const char log_fmt_dropped[] LOG_STR_ATTR = "log: %u records dropped";
+
+
+/*
+ * Claims the slot at head with a compare-and-swap (LDREX/STREX on
+ * Cortex-M, so interrupts stay enabled), fills it and publishes it by
+ * storing its sequence number last. The drain task never reads a slot
+ * before that store, and a slot is only reused once the drain task has
+ * moved tail past it.
+ */
+void log_write(const char *fmt, const uint32_t *args, uint32_t nargs){
+    uint32_t head = __atomic_load_n(&log_head, __ATOMIC_RELAXED);
+
+    do {
+        if (head - __atomic_load_n(&log_tail, __ATOMIC_ACQUIRE) >= LOG_RING_RECORDS){
+            __atomic_fetch_add(&log_dropped, 1U, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&log_head, &head, head + 1U, 1,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    log_record_t *rec = &log_ring[head & LOG_RING_MASK];
+
+    rec->fmt = fmt;
+    rec->timestamp = g_tick_count;
+    rec->nargs = nargs;
+    for (uint32_t i = 0; i < nargs; i++){
+        rec->args[i] = args[i];
+    }
+
+    __atomic_store_n(&rec->seq, head + 1U, __ATOMIC_RELEASE);
+}
+
+
+/*
+ * Emits records in order until the next one is not complete yet (a
+ * producer that was interrupted between claiming and publishing its
+ * slot); that one and the ones behind it go out on the next flush.
+ */
+void log_flush(void){
+    uint32_t tail = log_tail;
+
+    while (1){
+        log_record_t *rec = &log_ring[tail & LOG_RING_MASK];
+
+        if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != tail + 1U){
+            break;
+        }
+
+        port_log_emit(rec->fmt, rec->timestamp, rec->args, rec->nargs);
+
+        tail++;
+        __atomic_store_n(&log_tail, tail, __ATOMIC_RELEASE);
+    }
+
+    uint32_t dropped = __atomic_exchange_n(&log_dropped, 0U, __ATOMIC_RELAXED);
+    if (dropped){
+        port_log_emit(log_fmt_dropped, g_tick_count, &dropped, 1U);
+    }
+}
+
+
+static void log_drain_task(void *arg){
+    (void)arg;
+
+    while (1){
+        log_flush();
+        task_delay(LOG_DRAIN_TICKS);
+    }
+}
+
+
+int log_service_start(uint32_t stack_size, task_priority_t priority){
+    return (task_create(log_drain_task, NULL, stack_size, priority) == TASK_HANDLE_INVALID) ? -1 : 0;
+}
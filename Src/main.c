@@ -1,45 +1,34 @@
 #include "main.h"
+#include "soft_timer.h"
+#include "log.h"
 
 
-void idle_task(void *arg){
-    while(1);
-}
+/* Each LED blinks from an auto-reload timer in the timer-service task */
+typedef struct {
+    uint8_t led;
+    uint32_t half_period;       // Ticks between toggles
+    soft_timer_t timer;
+} blink_t;
 
+static blink_t blinks[] = {
+    { .led = LED_GREEN,  .half_period = 1000 },
+    { .led = LED_RED,    .half_period = 500 },
+    { .led = LED_BLUE,   .half_period = 250 },
+    { .led = LED_ORANGE, .half_period = 125 },
+};
 
-void green_task(void *arg){
-    while(1){
-        led_on(LED_GREEN);
-        task_delay(1000);
-        led_off(LED_GREEN);
-        task_delay(1000);
-    }
-}
 
-void red_task(void *arg){
+void idle_task(void *arg){
     while(1){
-        led_on(LED_RED);
-        task_delay(500);
-        led_off(LED_RED);
-        task_delay(500);
+        scheduler_idle_sleep();
     }
 }
 
-void blue_task(void *arg){
-    while(1){
-        led_on(LED_BLUE);
-        task_delay(250);
-        led_off(LED_BLUE);
-        task_delay(250);
-    }
-}
 
-void orange_task(void *arg){
-    while (1){
-        led_on(LED_ORANGE);
-        task_delay(125);
-        led_off(LED_ORANGE);
-        task_delay(125);
-    }
+static void blink_callback(void *arg){
+    blink_t *blink = arg;
+
+    led_toggle(blink->led);
 }
 
 int main(void){
@@ -50,10 +39,14 @@ int main(void){
     led_init_all();
 
     task_create_idle(idle_task, NULL, 256);
-    task_create(green_task, NULL, 512, TASK_PRIORITY_MEDIUM);
-    task_create(blue_task, NULL, 512, TASK_PRIORITY_MEDIUM);
-    task_create(red_task, NULL, 512, TASK_PRIORITY_MEDIUM);
-    task_create(orange_task, NULL, 512, TASK_PRIORITY_MEDIUM);
+    soft_timer_service_start(512, TASK_PRIORITY_HIGH);
+    log_service_start(512, TASK_PRIORITY_LOW);
+
+    for (uint32_t i = 0; i < sizeof(blinks) / sizeof(blinks[0]); i++){
+        soft_timer_init(&blinks[i].timer, blink_callback, &blinks[i]);
+        soft_timer_start(&blinks[i].timer, blinks[i].half_period, blinks[i].half_period);
+        LOG("blink: led %u every %u ticks", blinks[i].led, blinks[i].half_period);
+    }
 
     init_systick_timer(TICK_HZ);
 
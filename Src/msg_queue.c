@@ -0,0 +1,138 @@
+#include "msg_queue.h"
+#include "cpu_defs.h"
+#include "scheduler.h"
+
+
+extern TCB_t tcb_pool[MAX_TASKS];
+
+
+int msg_queue_init(msg_queue_t *queue, void **storage, uint32_t capacity){
+    if (!storage || capacity == 0){
+        return -1;
+    }
+
+    queue->slots = storage;
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->count = 0;
+    list_init(&queue->receivers);
+    list_init(&queue->senders);
+
+    return 0;
+}
+
+
+/*
+ * Hand msg to a waiting receiver or append it.
+ * Must be called inside a kernel critical section (CRITICAL_ENTER).
+ */
+static int queue_post(msg_queue_t *queue, void *msg){
+    list_node_t *node = list_first(&queue->receivers);
+
+    if (node){
+        TCB_t *receiver = LIST_ENTRY(node, TCB_t, event_node);
+
+        receiver->wait_data = msg;
+        scheduler_wake(receiver, WAIT_OK);
+        return 0;
+    }
+
+    if (queue->count == queue->capacity){
+        return -1;
+    }
+
+    uint32_t tail = queue->head + queue->count;
+    if (tail >= queue->capacity){
+        tail -= queue->capacity;
+    }
+    queue->slots[tail] = msg;
+    queue->count++;
+
+    return 0;
+}
+
+
+int msg_queue_send(msg_queue_t *queue, void *msg, uint32_t timeout_ticks){
+    CRITICAL_ENTER();
+
+    if (queue_post(queue, msg) == 0){
+        CRITICAL_EXIT();
+        return 0;
+    }
+
+    TCB_t *self = scheduler_current_tcb();
+
+    /* The idle task must never block */
+    if (timeout_ticks == 0 || self == &tcb_pool[0]){
+        CRITICAL_EXIT();
+        return -1;
+    }
+
+    self->wait_data = msg;
+    scheduler_block_current(&queue->senders, timeout_ticks);
+
+    CRITICAL_EXIT();
+
+    /* Switched out here until a receiver makes room for msg or the timeout expires */
+
+    return (self->wait_status == WAIT_OK) ? 0 : -1;
+}
+
+
+int msg_queue_send_from_isr(msg_queue_t *queue, void *msg){
+    CRITICAL_ENTER();
+
+    int result = queue_post(queue, msg);
+
+    CRITICAL_EXIT();
+
+    return result;
+}
+
+
+void *msg_queue_receive(msg_queue_t *queue, uint32_t timeout_ticks){
+    CRITICAL_ENTER();
+
+    if (queue->count){
+        void *msg = queue->slots[queue->head];
+
+        queue->head++;
+        if (queue->head == queue->capacity){
+            queue->head = 0;
+        }
+        queue->count--;
+
+        /* The freed slot goes to the highest priority blocked sender */
+        list_node_t *node = list_first(&queue->senders);
+        if (node){
+            TCB_t *sender = LIST_ENTRY(node, TCB_t, event_node);
+
+            queue_post(queue, sender->wait_data);
+            scheduler_wake(sender, WAIT_OK);
+        }
+
+        CRITICAL_EXIT();
+        return msg;
+    }
+
+    TCB_t *self = scheduler_current_tcb();
+
+    /* The idle task must never block */
+    if (timeout_ticks == 0 || self == &tcb_pool[0]){
+        CRITICAL_EXIT();
+        return NULL;
+    }
+
+    scheduler_block_current(&queue->receivers, timeout_ticks);
+
+    CRITICAL_EXIT();
+
+    /* Switched out here until a sender hands us a message or the timeout expires */
+
+    return (self->wait_status == WAIT_OK) ? self->wait_data : NULL;
+}
+
+
+uint32_t msg_queue_count(const msg_queue_t *queue){
+    return queue->count;
+}
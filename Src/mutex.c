@@ -0,0 +1,153 @@
+#include "mutex.h"
+#include "cpu_defs.h"
+#include "scheduler.h"
+
+
+extern TCB_t tcb_pool[MAX_TASKS];
+
+/* Highest priority a task needs: its own or that of a task waiting on it */
+static uint8_t inherited_priority(const TCB_t *tcb){
+    uint8_t priority = tcb->base_priority;
+
+    for (list_node_t *node = tcb->mutexes_held.next; node != &tcb->mutexes_held; node = node->next){
+        list_node_t *waiter = list_first(&LIST_ENTRY(node, mutex_t, held_node)->waiters);
+
+        if (waiter){
+            uint8_t waiter_priority = LIST_ENTRY(waiter, TCB_t, event_node)->priority;
+            if (waiter_priority < priority){
+                priority = waiter_priority;
+            }
+        }
+    }
+
+    return priority;
+}
+
+
+void mutex_priority_update(TCB_t *tcb){
+    /*
+     * Walk the chain task -> mutex it waits on -> owner of that mutex.
+     * The walk stops as soon as a priority does not change, and is
+     * bounded by the number of tasks in case of a lock cycle.
+     */
+    for (int depth = 0; tcb && depth < MAX_TASKS; depth++){
+        uint8_t priority = inherited_priority(tcb);
+
+        if (priority == tcb->priority){
+            break;
+        }
+        scheduler_set_priority(tcb, priority);
+
+        tcb = tcb->wait_mutex ? tcb->wait_mutex->owner : NULL;
+    }
+}
+
+
+static void mutex_take(mutex_t *mutex, TCB_t *tcb){
+    mutex->owner = tcb;
+    list_push_back(&tcb->mutexes_held, &mutex->held_node);
+}
+
+
+/* Take the mutex from its owner and hand it to the highest priority waiter */
+static void mutex_release(mutex_t *mutex){
+    list_remove(&mutex->held_node);
+    mutex->owner = NULL;
+
+    list_node_t *node = list_first(&mutex->waiters);
+    if (node){
+        TCB_t *next = LIST_ENTRY(node, TCB_t, event_node);
+
+        scheduler_wake(next, WAIT_OK);
+        next->wait_mutex = NULL;
+        mutex_take(mutex, next);
+
+        /* The remaining waiters now boost the new owner */
+        mutex_priority_update(next);
+    }
+}
+
+
+void mutex_init(mutex_t *mutex){
+    mutex->owner = NULL;
+    list_init(&mutex->waiters);
+    list_node_init(&mutex->held_node);
+}
+
+
+int mutex_lock(mutex_t *mutex, uint32_t timeout_ticks){
+    CRITICAL_ENTER();
+
+    TCB_t *self = scheduler_current_tcb();
+
+    if (!mutex->owner){
+        mutex_take(mutex, self);
+        CRITICAL_EXIT();
+        return 0;
+    }
+
+    /* Not recursive; the idle task must never block */
+    if (mutex->owner == self || timeout_ticks == 0 || self == &tcb_pool[0]){
+        CRITICAL_EXIT();
+        return -1;
+    }
+
+    self->wait_mutex = mutex;
+    scheduler_block_current(&mutex->waiters, timeout_ticks);
+
+    /* Lend our priority to the owner (and whatever it is waiting on) */
+    mutex_priority_update(mutex->owner);
+
+    CRITICAL_EXIT();
+
+    /* Switched out here until mutex_unlock() hands us the mutex or the wait times out */
+
+    CRITICAL_ENTER();
+
+    self->wait_mutex = NULL;
+    int status = self->wait_status;
+
+    /* We no longer wait: the owner may not need our priority any more */
+    if (status != WAIT_OK && mutex->owner){
+        mutex_priority_update(mutex->owner);
+    }
+
+    CRITICAL_EXIT();
+
+    return (status == WAIT_OK) ? 0 : -1;
+}
+
+
+int mutex_trylock(mutex_t *mutex){
+    return mutex_lock(mutex, 0);
+}
+
+
+int mutex_unlock(mutex_t *mutex){
+    CRITICAL_ENTER();
+
+    TCB_t *self = scheduler_current_tcb();
+
+    if (mutex->owner != self){
+        CRITICAL_EXIT();
+        return -1;
+    }
+
+    mutex_release(mutex);
+
+    /* Drop any priority inherited through this mutex (may switch to next) */
+    mutex_priority_update(self);
+
+    CRITICAL_EXIT();
+
+    return 0;
+}
+
+
+void mutex_release_all(TCB_t *tcb){
+    list_node_t *node;
+
+    while ((node = list_first(&tcb->mutexes_held)) != NULL){
+        mutex_release(LIST_ENTRY(node, mutex_t, held_node));
+    }
+}
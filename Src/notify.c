@@ -0,0 +1,108 @@
+#include "notify.h"
+#include "cpu_defs.h"
+#include "scheduler.h"
+
+
+extern TCB_t tcb_pool[MAX_TASKS];
+
+
+/*
+ * Update the notification word and wake the task if it waits.
+ * Must be called inside a kernel critical section (CRITICAL_ENTER).
+ */
+static int notify(TCB_t *tcb, uint32_t value, notify_action_t action){
+    switch (action){
+    case NOTIFY_SET_BITS:
+        tcb->notify_value |= value;
+        break;
+
+    case NOTIFY_INCREMENT:
+        tcb->notify_value++;
+        break;
+
+    case NOTIFY_OVERWRITE:
+        tcb->notify_value = value;
+        break;
+
+    case NOTIFY_NO_OVERWRITE:
+        if (tcb->notify_state == NOTIFY_STATE_PENDING){
+            return -1;
+        }
+        tcb->notify_value = value;
+        break;
+
+    default:
+        break;
+    }
+
+    if (tcb->notify_state == NOTIFY_STATE_WAITING){
+        scheduler_wake(tcb, WAIT_OK);
+    }
+    tcb->notify_state = NOTIFY_STATE_PENDING;
+
+    return 0;
+}
+
+
+int task_notify(task_handle_t task, uint32_t value, notify_action_t action){
+    CRITICAL_ENTER();
+
+    int result = -1;
+    TCB_t *tcb = task_from_handle(task);
+    if (tcb){
+        result = notify(tcb, value, action);
+    }
+
+    CRITICAL_EXIT();
+
+    return result;
+}
+
+
+int task_notify_from_isr(task_handle_t task, uint32_t value, notify_action_t action){
+    /*
+     * The wake-up only pends the context switch, which runs once the
+     * interrupt returns, so the task path is safe here as well.
+     */
+    return task_notify(task, value, action);
+}
+
+
+int task_notify_wait(uint32_t timeout_ticks, uint32_t *value){
+    CRITICAL_ENTER();
+
+    TCB_t *self = scheduler_current_tcb();
+
+    if (self->notify_state != NOTIFY_STATE_PENDING){
+        /* The idle task must never block */
+        if (timeout_ticks == 0 || self == &tcb_pool[0]){
+            CRITICAL_EXIT();
+            return -1;
+        }
+
+        self->notify_state = NOTIFY_STATE_WAITING;
+        scheduler_block_current(NULL, timeout_ticks);
+
+        CRITICAL_EXIT();
+
+        /* Switched out here until notified or the timeout expires */
+
+        CRITICAL_ENTER();
+
+        if (self->wait_status != WAIT_OK){
+            self->notify_state = NOTIFY_STATE_IDLE;
+            CRITICAL_EXIT();
+            return -1;
+        }
+    }
+
+    if (value){
+        *value = self->notify_value;
+    }
+    self->notify_value = 0;
+    self->notify_state = NOTIFY_STATE_IDLE;
+
+    CRITICAL_EXIT();
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include "ready_queue.h"
+#include "cpu_defs.h"
+
+
+static list_t ready_lists[TASK_PRIORITY_LEVELS] PORT_FAST_BSS;
+static uint32_t ready_bitmap PORT_FAST_BSS = 0;
+
+
+/* Round-robin and deadline modes: every non-idle task shares level 0 */
+static ready_queue_mode_t queue_mode = READY_QUEUE_PRIORITY;
+
+
+#define PRIO_BIT(prio)   (0x80000000U >> (prio))
+
+
+void ready_queue_init(void){
+    for (uint32_t i = 0; i < TASK_PRIORITY_LEVELS; i++){
+        list_init(&ready_lists[i]);
+    }
+    ready_bitmap = 0;
+}
+
+
+void ready_queue_set_mode(ready_queue_mode_t mode){
+    queue_mode = mode;
+}
+
+
+/* a has a later deadline than b; tasks without a deadline come last */
+static inline int deadline_after(const TCB_t *a, const TCB_t *b){
+    if (!b->has_deadline){
+        return 0;
+    }
+    return !a->has_deadline || (int32_t)(a->deadline - b->deadline) > 0;
+}
+
+/* Insert behind every task with the same or an earlier deadline */
+static void deadline_insert(list_t *list, TCB_t *tcb){
+    list_node_t *pos = list->next;
+
+    while (pos != list){
+        if (deadline_after(LIST_ENTRY(pos, TCB_t, state_node), tcb)){
+            break;
+        }
+        pos = pos->next;
+    }
+
+    list_insert_before(pos, &tcb->state_node);
+}
+
+
+void ready_queue_insert(TCB_t *tcb){
+    /* The level is kept in the TCB so removal matches even if the mode changed */
+    uint8_t level = (queue_mode != READY_QUEUE_PRIORITY && tcb->priority != TASK_PRIORITY_IDLE) ? 0U : tcb->priority;
+
+    tcb->ready_level = level;
+    if (queue_mode == READY_QUEUE_DEADLINE && level == 0U){
+        deadline_insert(&ready_lists[0], tcb);
+    }else{
+        list_push_back(&ready_lists[level], &tcb->state_node);
+    }
+    ready_bitmap |= PRIO_BIT(level);
+}
+
+
+void ready_queue_remove(TCB_t *tcb){
+    if (!list_node_linked(&tcb->state_node)){
+        return;
+    }
+
+    list_remove(&tcb->state_node);
+
+    if (list_empty(&ready_lists[tcb->ready_level])){
+        ready_bitmap &= ~PRIO_BIT(tcb->ready_level);
+    }
+}
+
+
+TCB_t *ready_queue_peek(void){
+    if (!ready_bitmap){
+        return NULL;
+    }
+
+    /* Lowest bit position counted from the MSB = highest priority */
+    uint32_t prio = (uint32_t)__builtin_clz(ready_bitmap);
+
+    return LIST_ENTRY(ready_lists[prio].next, TCB_t, state_node);
+}
+
+
+int ready_queue_is_only(const TCB_t *tcb){
+    const list_t *list = &ready_lists[tcb->ready_level];
+
+    return (ready_bitmap == PRIO_BIT(tcb->ready_level)) &&
+           (list->next == &tcb->state_node) && (list->prev == &tcb->state_node);
+}
+
+
+void ready_queue_rotate(TCB_t *tcb){
+    list_t *list = &ready_lists[tcb->ready_level];
+
+    /* Nothing to do if not ready or already the only/last task */
+    if (!list_node_linked(&tcb->state_node) || tcb->state_node.next == list){
+        return;
+    }
+
+    list_remove(&tcb->state_node);
+    if (queue_mode == READY_QUEUE_DEADLINE && tcb->ready_level == 0U){
+        deadline_insert(list, tcb);
+    }else{
+        list_push_back(list, &tcb->state_node);
+    }
+}
@@ -0,0 +1,146 @@
+#include <string.h>
+
+#include "ring_buffer.h"
+#include "cpu_defs.h"
+#include "scheduler.h"
+
+
+extern TCB_t tcb_pool[MAX_TASKS];
+
+
+int ring_init(ring_buffer_t *ring, uint8_t *storage, uint32_t capacity){
+    if (!storage || capacity == 0 || (capacity & (capacity - 1))){
+        return -1;
+    }
+
+    ring->buf = storage;
+    ring->mask = capacity - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    list_init(&ring->readers);
+
+    return 0;
+}
+
+
+uint32_t ring_count(const ring_buffer_t *ring){
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+
+uint32_t ring_space(const ring_buffer_t *ring){
+    return ring->mask + 1 - ring_count(ring);
+}
+
+
+/* Hand the new data to a blocked reader */
+static void ring_wake_reader(ring_buffer_t *ring){
+    CRITICAL_ENTER();
+
+    list_node_t *node = list_first(&ring->readers);
+    if (node){
+        scheduler_wake(LIST_ENTRY(node, TCB_t, event_node), WAIT_OK);
+    }
+
+    CRITICAL_EXIT();
+}
+
+
+uint32_t ring_push_n(ring_buffer_t *ring, const uint8_t *data, uint32_t n){
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t space = ring->mask + 1 - (head - tail);
+
+    if (n > space){
+        n = space;
+    }
+    if (!n){
+        return 0;
+    }
+
+    /* At most two copies: up to the end of the storage, then from the start */
+    uint32_t index = head & ring->mask;
+    uint32_t first = ring->mask + 1 - index;
+    if (first > n){
+        first = n;
+    }
+    memcpy(&ring->buf[index], data, first);
+    memcpy(ring->buf, data + first, n - first);
+
+    /* Publish the bytes, then look for a reader that went to sleep before seeing them */
+    __atomic_store_n(&ring->head, head + n, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&ring->readers.next, __ATOMIC_RELAXED) != &ring->readers){
+        ring_wake_reader(ring);
+    }
+
+    return n;
+}
+
+
+uint32_t ring_pop_n(ring_buffer_t *ring, uint8_t *data, uint32_t n){
+    uint32_t tail = ring->tail;
+    uint32_t count = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+
+    if (n > count){
+        n = count;
+    }
+    if (!n){
+        return 0;
+    }
+
+    uint32_t index = tail & ring->mask;
+    uint32_t first = ring->mask + 1 - index;
+    if (first > n){
+        first = n;
+    }
+    memcpy(data, &ring->buf[index], first);
+    memcpy(data + first, ring->buf, n - first);
+
+    /* Release the slots only after the bytes have been copied out */
+    __atomic_store_n(&ring->tail, tail + n, __ATOMIC_RELEASE);
+
+    return n;
+}
+
+
+int ring_push(ring_buffer_t *ring, uint8_t byte){
+    return ring_push_n(ring, &byte, 1) ? 0 : -1;
+}
+
+
+int ring_pop(ring_buffer_t *ring, uint8_t *byte){
+    return ring_pop_n(ring, byte, 1) ? 0 : -1;
+}
+
+
+uint32_t ring_read(ring_buffer_t *ring, uint8_t *data, uint32_t n, uint32_t timeout_ticks){
+    uint32_t got = ring_pop_n(ring, data, n);
+
+    if (got || !n || timeout_ticks == 0){
+        return got;
+    }
+
+    CRITICAL_ENTER();
+
+    TCB_t *self = scheduler_current_tcb();
+
+    /*
+     * Register as the reader and check again: a producer that pushed
+     * before the registration is seen here, one that pushes after it
+     * sees the reader and wakes us. The idle task must never block.
+     * Waiting on the readers list lets a timeout or task_delete() take
+     * the reader off again, like any other object wait.
+     */
+    if (self != &tcb_pool[0] && ring_count(ring) == 0){
+        scheduler_block_current(&ring->readers, timeout_ticks);
+    }
+
+    CRITICAL_EXIT();
+
+    /* Switched out here until the producer pushes or the timeout expires */
+
+    return ring_pop_n(ring, data, n);
+}
@@ -0,0 +1,76 @@
+#include "cpu_defs.h"
+#include "scheduler.h"
+#include "runtime_stats.h"
+
+#if RUNTIME_STATS
+
+extern TCB_t tcb_pool[MAX_TASKS];
+
+
+static uint16_t permille(uint64_t part, uint64_t whole){
+    if (!whole){
+        return 0;
+    }
+    return (uint16_t)((part * 1000U + whole / 2U) / whole);
+}
+
+
+uint32_t runtime_stats_sample(task_runtime_t *tasks, uint32_t max_tasks, runtime_window_t *window){
+    uint64_t window_cycles;
+    uint64_t idle_cycles = 0;
+    uint32_t total_switches = 0;
+    uint32_t count = 0;
+
+    CRITICAL_ENTER();
+
+    scheduler_runtime_sync();
+    window_cycles = scheduler_runtime_window();
+
+    /*
+     * Take the deltas and move the marks in one pass with interrupts
+     * off, so the window is consistent across tasks.
+     */
+    for (int i = 0; i < MAX_TASKS; i++){
+        TCB_t *tcb = &tcb_pool[i];
+        TCB_cold_t *cold = &tcb_cold[i];
+
+        if (tcb->state == TASK_STATE_UNUSED){
+            continue;
+        }
+
+        uint64_t cycles = tcb->run_cycles - cold->run_cycles_mark;
+        uint32_t switches = tcb->switch_count - cold->switch_count_mark;
+
+        cold->run_cycles_mark = tcb->run_cycles;
+        cold->switch_count_mark = tcb->switch_count;
+
+        total_switches += switches;
+        if (i == 0){
+            idle_cycles = cycles;
+        }
+
+        if (tasks && count < max_tasks){
+            tasks[count].task = task_handle_of(tcb);
+            tasks[count].priority = tcb->priority;
+            tasks[count].switches = switches;
+            tasks[count].cycles = cycles;
+            count++;
+        }
+    }
+
+    CRITICAL_EXIT();
+
+    for (uint32_t i = 0; i < count; i++){
+        tasks[i].cpu_permille = permille(tasks[i].cycles, window_cycles);
+    }
+
+    if (window){
+        window->cycles = window_cycles;
+        window->switches = total_switches;
+        window->idle_permille = permille(idle_cycles, window_cycles);
+    }
+
+    return count;
+}
+
+#endif /* RUNTIME_STATS */
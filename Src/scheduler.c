@@ -1,30 +1,55 @@
 #include "cpu_defs.h"
 #include "tasks.h"
-#include "regs.h"
 #include "scheduler.h"
+#include "ready_queue.h"
+#include "port.h"
+#include "mutex.h"
+#include "soft_timer.h"
+#include "trace.h"
 /* denotes the current task which is running in the CPU */
-uint8_t current_task = 0; // must start from IDLE
-uint32_t g_tick_count = 0;
+uint16_t current_task PORT_FAST_BSS = 0; // must start from IDLE
+uint32_t g_tick_count PORT_FAST_BSS = 0;
 
 
 extern TCB_t tcb_pool[MAX_TASKS];
 sched_algo_t active_scheduler = SCHED_PRIORITY;
 
+/* Delayed tasks ordered by wake-up tick (earliest first) */
+static list_t delay_list PORT_FAST_DATA = { &delay_list, &delay_list };
+
+/* Ticks that did / did not need a context switch */
+static sched_tick_stats_t tick_stats = {0};
+
+/* Set once the first task runs; no preemption while tasks are created in main */
+static uint8_t scheduler_running = 0;
+
+#if RUNTIME_STATS
+/* Runtime counter value when the current task was switched in */
+static uint32_t runtime_stamp PORT_FAST_BSS = 0;
+
+/* Runtime counter value at the start of the current stats window */
+static uint32_t runtime_window_stamp = 0;
+#endif
+
 
 /* ------------------------------------------------------------
  *             Scheduler policy selection helpers
  * -----------------------------------------------------------
  * 
  * These functions implement task-selection logic for different
- * scheduling policies (Round-Robin, Priority).
- * They do NOT perform context switching.
+ * scheduling policies (Round-Robin, Priority, EDF).
+ * They do NOT perform context switching and have no side effects.
  * They only select the index of the next READY task.
  * Task index 0 is reserved for the idle task and is selected
  * only if no user task is READY.
  * ------------------------------------------------------------ */
 
-static uint8_t sched_rr_select_next_task(void);
-static uint8_t sched_priority_select_next_task(void);
+static uint16_t sched_rr_select_next_task(void);
+static uint16_t sched_priority_select_next_task(void);
+static uint16_t sched_edf_select_next_task(void);
+static void delay_list_insert(TCB_t *tcb);
+static void delay_current_until(uint32_t wake_tick);
+static void wait_list_insert(list_t *wait_list, TCB_t *tcb);
 
 
 /* ------------------------------------------------------------
@@ -36,178 +61,217 @@ void update_global_tick_count(void){
 }
 
 
+/*
+ * Wakes every task whose delay or object wait timeout has expired.
+ * The delay list is sorted by wake-up tick, so only the head needs to be
+ * compared: if it is not due, nothing behind it is either. The common
+ * case (nothing due) costs a single compare regardless of task count.
+ */
 void unblock_tasks(void){
-    /* Skip task 0 (idle task) */
-    for (int i = 1; i < MAX_TASKS; i++){
+    list_node_t *node;
 
-        /* Only blocked tasks can be unblocked */
-        if (tcb_pool[i].state != TASK_STATE_BLOCKED){
-            continue;
-        }
+    while ((node = list_first(&delay_list)) != NULL){
+        TCB_t *tcb = LIST_ENTRY(node, TCB_t, state_node);
 
         /* Check if the delay period has expired (overflow safe) */
-        if ((int32_t)(g_tick_count - tcb_pool[i].block_count) >= 0){
-            tcb_pool[i].state = TASK_STATE_READY;
+        if ((int32_t)(g_tick_count - tcb->block_count) < 0){
+            break;
+        }
+
+        if (tcb->state == TASK_STATE_BLOCKED_OBJ){
+            scheduler_wake(tcb, WAIT_TIMEOUT);
+        }else{
+            list_remove(node);
+            scheduler_make_ready(tcb);
         }
     }
 }
 
 
-__attribute__((naked)) void scheduler_start(void){
-
-    __asm volatile(
-        "CPSID I              \n" /* Disable interrupts */
-        /* Get first task PSP */
-        "BL    update_next_task \n"
-        "BL    get_psp_value    \n"
-
-        /* Restore software context (R4-R11) */
-        "LDMIA R0!, {R4-R11}  \n"
-
-        /* Load PSP of selected task and switch to PSP */
-        "MSR   PSP, R0          \n"
-        "MOV   R0, #0x02        \n"
-        "MSR   CONTROL, R0      \n"
-        "ISB                    \n"
+/*
+ * Makes a task READY and preempts the running task right away if the
+ * woken task outranks it. Every kernel wake-up path goes through here.
+ * Must be called inside a kernel critical section (CRITICAL_ENTER).
+ */
+void scheduler_make_ready(TCB_t *tcb){
+    tcb->state = TASK_STATE_READY;
+    tcb->slice_left = tcb->time_slice;
+    TRACE_EVENT(TRACE_EVT_READY, tcb - tcb_pool, 0U);
+    ready_queue_insert(tcb);
 
-        /* Restore hardware context and jump to task */
-        "POP   {R0-R3, R12, LR} \n"
-        "CPSIE I                \n" /* Enable interrupts */
-        "POP   {PC}             \n"
-        :
-        :
-        : "memory"
-    );
+    scheduler_preempt_check();
 }
 
 
-/* ------------------------------------------------------------
- * SysTick ISR
- * ------------------------------------------------------------ */
+/*
+ * Requests a context switch if a READY task now has a higher priority
+ * (EDF: an earlier deadline) than the running task, or the running task
+ * is no longer READY. Round-robin does not preempt a running task for
+ * an equal one and leaves that to the tick, but a task that becomes
+ * ready while the idle task runs is switched to at once. The switch
+ * happens as soon as interrupts are enabled again.
+ */
+void scheduler_preempt_check(void){
+    if (!scheduler_running){
+        return;
+    }
 
-void SysTick_Handler(void){
-    update_global_tick_count();
-    unblock_tasks();
+    TCB_t *best = ready_queue_peek();
+    TCB_t *running = &tcb_pool[current_task];
 
-    schedule();
+    if (!best || best == running){
+        return;
+    }
+
+    if (running->state != TASK_STATE_READY || running == &tcb_pool[0]){
+        schedule();
+    }else if (active_scheduler == SCHED_RR){
+        return;         // equal turns, rotated by the tick
+    }else if (active_scheduler == SCHED_EDF){
+        /*
+         * Equal deadlines queue behind the running task, so a different
+         * head means a strictly earlier deadline.
+         */
+        schedule();
+    }else if (best->priority < running->priority){
+        schedule();
+    }
 }
 
-/* ------------------------------------------------------------
- * PendSV ISR (context switch)
- * ------------------------------------------------------------ */
 
 /*
- * PendSV_Handler
- * ---------------
- * Performs a context switch between tasks.
- *
- * PendSV runs in handler mode using MSP, while tasks run in thread mode using PSP.
- * This handler saves the context of the current task, selects the next task to run,
- * restores its context and returns to thread mode.
+ * Selects the first task to run and hands over to the port, which
+ * switches to its stack. Never returns.
  */
-__attribute__((naked)) void PendSV_Handler(void){
-    __asm volatile(
-        /* ------------------------------------------------------------
-         * Step 1: Save context of the currently running task (PSP)
-         * ------------------------------------------------------------ */
-
-        "MRS   R0, PSP        \n"   // store current running task PSP value into R0
-        "STMDB R0!, {R4-R11}  \n"   // store R4-R11 register onto the stack
-        /*
-         * Save callee-saved registers R4–R11 onto the task stack.
-         * STMDB (Decrement Before) creates space first, then stores.
-         *
-         * Effect (conceptual):
-         *   R0 = R0 - 32;              // 8 registers × 4 bytes
-         *   [R0 + 0]  = R4;
-         *   [R0 + 4]  = R5;
-         *   ...
-         *   [R0 + 28] = R11;
-         */
-
-        "MSR   PSP, R0        \n"   // update PSP to new top of stack
+void scheduler_start(void){
+    INTERRUPT_DISABLE();
 
-        /* ------------------------------------------------------------
-         * Step 2: Call scheduler functions (use MSP)
-         * ------------------------------------------------------------ */
+#if RUNTIME_STATS
+    port_init_runtime_counter();
+    runtime_stamp = port_runtime_counter();
+    runtime_window_stamp = runtime_stamp;
+#endif
 
-        /*
-         * Protect LR (contains EXC_RETURN) and ensure a valid stack
-         * for C function calls. PUSH/POP operate on MSP in handler mode.
-         */
-        "PUSH  {LR}           \n"
+    update_next_task();
+    scheduler_running = 1;
+    port_start_first_task();
+}
 
-        /* Save PSP of current task, select next task to run and get its PSP */
-        "BL    save_psp_value \n"
-        "BL    update_next_task \n"
-        "BL    get_psp_value  \n"
 
-        /* Restore EXC_RETURN value into LR */
-        "POP   {LR}           \n"
+/*
+ * Tick processing, called by the port's tick interrupt
+ * (SysTick_Handler on Cortex-M).
+ */
+void scheduler_tick(void){
+    update_global_tick_count();
+    unblock_tasks();
+    soft_timer_tick();
 
-        /*
-         * Restore callee-saved registers R4–R11 from the next task's stack.
-         * LDMIA (Increment After) reverses the earlier STMDB.
-         */
-        "LDMIA R0!, {R4-R11}  \n"
+    /*
+     * Time slice over: let the next task of the same priority run. A
+     * preempted task keeps what is left of its slice; one that blocked
+     * starts a full slice when it is made ready again.
+     */
+    TCB_t *running = &tcb_pool[current_task];
+    if (running->state == TASK_STATE_READY && --running->slice_left == 0){
+        running->slice_left = running->time_slice;
+        ready_queue_rotate(running);
+    }
 
-        /* Update PSP to point above the restored context */
-        "MSR   PSP, R0        \n"
+    /*
+     * Only pend PendSV if the selection changes. A lone busy task or the
+     * idle task keeps running without saving and restoring its context.
+     */
+    if (scheduler_select_next_task() != current_task){
+        tick_stats.switched++;
+        schedule();
+    }else{
+        tick_stats.skipped++;
+    }
+}
 
-        /* ------------------------------------------------------------
-         * Step 4: Exception return
-         * ------------------------------------------------------------ */
 
-        /*
-         * BX LR triggers exception return using EXC_RETURN.
-         * The CPU automatically restores:
-         *   R0–R3, R12, LR, PC, xPSR
-         * and resumes execution of the selected task in thread mode.
-         */
-        "BX    LR             \n"
-    );
+void scheduler_tick_stats(sched_tick_stats_t *stats){
+    CRITICAL_ENTER();
+    *stats = tick_stats;
+    CRITICAL_EXIT();
 }
 
-
 /* ------------------------------------------------------------
  * Scheduler helpers
  * ------------------------------------------------------------ */
 
 
-void save_psp_value(uint32_t current_psp_val){
+void save_psp_value(uintptr_t current_psp_val){
     tcb_pool[current_task].psp = (uint32_t *)current_psp_val;
 }
 
 void update_next_task(void){
-    switch (active_scheduler)
-    {
-    case SCHED_RR:
-        current_task = sched_rr_select_next_task();
-        break;
+#if RUNTIME_STATS || TRACE_ENABLE
+    uint16_t prev_task = current_task;
+#endif
 
-    case SCHED_PRIORITY:
-        current_task = sched_priority_select_next_task();
-        break;
-    
-    default:
-        current_task = 0;
-        break;
+    current_task = scheduler_select_next_task();
+
+#if TRACE_ENABLE
+    if (current_task != prev_task){
+        TRACE_EVENT(TRACE_EVT_SWITCH_OUT, prev_task, tcb_pool[prev_task].state);
+        TRACE_EVENT(TRACE_EVT_SWITCH_IN, current_task, 0U);
+    }
+#endif
+
+#if RUNTIME_STATS
+    /* Charge the outgoing task for the time since it was switched in */
+    uint32_t now = port_runtime_counter();
+
+    tcb_pool[prev_task].run_cycles += now - runtime_stamp;
+    runtime_stamp = now;
+
+    if (current_task != prev_task){
+        tcb_pool[current_task].switch_count++;
     }
-    
+#endif
 }
 
 
-uint32_t get_psp_value(void){
+uintptr_t get_psp_value(void){
 
-    return (uint32_t)tcb_pool[current_task].psp;
+    return (uintptr_t)tcb_pool[current_task].psp;
 }
 
 void schedule(void){
-    /* Request PendSV for context switching */
-    SCB_ICSR = SCB_ICSR_PENDSVSET;
+    /* Request a context switch (PendSV on Cortex-M) */
+    port_pend_switch();
 }
 
 
+#if RUNTIME_STATS
+/*
+ * Charges the running task up to now, so a stats snapshot includes the
+ * time of the task that takes it. Must be called inside a kernel critical section (CRITICAL_ENTER).
+ */
+void scheduler_runtime_sync(void){
+    uint32_t now = port_runtime_counter();
+
+    tcb_pool[current_task].run_cycles += now - runtime_stamp;
+    runtime_stamp = now;
+}
+
+
+/*
+ * Wall-clock length of the stats window that ends now, in runtime
+ * counter ticks, and start the next one. Must be called inside a kernel critical section (CRITICAL_ENTER).
+ */
+uint32_t scheduler_runtime_window(void){
+    uint32_t now = port_runtime_counter();
+    uint32_t elapsed = now - runtime_window_stamp;
+
+    runtime_window_stamp = now;
+    return elapsed;
+}
+#endif
+
+
 /* ------------------------------------------------------------
  * Task delay service
  * ------------------------------------------------------------ */
@@ -215,60 +279,372 @@ void schedule(void){
 
 void task_delay(uint32_t tick_count){
 
-    INTERRUPT_DISABLE();
+    CRITICAL_ENTER();
 
     /*
      * We are changing shared scheduler data here.
      * If an interrupt happens in the middle of this code,
      * the scheduler may see incomplete or wrong values.
      *
-     * So we temporarily disable interrupts to make sure
+     * So we hold a kernel critical section to make sure
      * this update happens safely and completely.   */
 
     /*
      * block_count stores the absolute tick value at which the task should wake up.
      *
      * Overflow is handled during unblock using:
-     * (int32_t)(g_tick_count - block_count) >= 0 */
+     * (int32_t)(g_tick_count - block_count) >= 0
+     * and the delay list is ordered with the same signed difference,
+     * which is correct as long as no delay exceeds 2^31 ticks. */
 
     if(current_task){  // task 0 = idle task
-        tcb_pool[current_task].block_count = g_tick_count + tick_count;
-        tcb_pool[current_task].state = TASK_STATE_BLOCKED;
+        delay_current_until(g_tick_count + tick_count);
+    }
+
+    CRITICAL_EXIT();
+}
+
+
+/*
+ * Periodic wait without drift: blocks until *last_wake + period_ticks
+ * and advances *last_wake to that tick, so the period is measured from
+ * the previous release, not from when the body finished. Initialise
+ * *last_wake with the current tick (g_tick_count) before the first call.
+ * A period_ticks of 0 uses the period declared with task_set_deadline().
+ *
+ * If the release is already due (the body overran), the task keeps
+ * running. Under SCHED_EDF the next job's absolute deadline is set to
+ * the release plus the task's relative deadline.
+ */
+void task_delay_until(uint32_t *last_wake, uint32_t period_ticks){
+    CRITICAL_ENTER();
+
+    if (!current_task){     // the idle task never blocks
+        CRITICAL_EXIT();
+        return;
+    }
+
+    TCB_t *tcb = &tcb_pool[current_task];
+    TCB_cold_t *cold = &tcb_cold[current_task];
+
+    if (period_ticks == 0){
+        period_ticks = cold->period;
+    }
+
+    uint32_t release = *last_wake + period_ticks;
+    *last_wake = release;
+
+    if (tcb->has_deadline){
+        tcb->deadline = release + cold->rel_deadline;
+    }
+
+    if ((int32_t)(release - g_tick_count) > 0){
+        delay_current_until(release);
+    }else if (tcb->has_deadline){
+        /* Overrun: the next job is released already, requeue it by its new deadline */
+        ready_queue_remove(tcb);
+        ready_queue_insert(tcb);
+        scheduler_preempt_check();
+    }
+
+    CRITICAL_EXIT();
+}
+
+
+/*
+ * Moves the running task to the delay list until wake_tick.
+ * Must be called inside a kernel critical section (CRITICAL_ENTER).
+ */
+static void delay_current_until(uint32_t wake_tick){
+    TCB_t *tcb = &tcb_pool[current_task];
+
+    tcb->block_count = wake_tick;
+    tcb->state = TASK_STATE_BLOCKED;
+    ready_queue_remove(tcb);
+    delay_list_insert(tcb);
+    TRACE_EVENT(TRACE_EVT_BLOCK, current_task, TRACE_BLOCK_DELAY);
+    schedule();
+}
+
+
+
+/*
+ * Inserts a task into the delay list behind every task that wakes up at
+ * the same tick or earlier, keeping the list sorted and FIFO for equal
+ * wake-up ticks. Runs in task context. Must be called inside a kernel critical section (CRITICAL_ENTER).
+ */
+static void delay_list_insert(TCB_t *tcb){
+    list_node_t *pos = delay_list.next;
+
+    while (pos != &delay_list){
+        TCB_t *other = LIST_ENTRY(pos, TCB_t, state_node);
+
+        if ((int32_t)(other->block_count - tcb->block_count) > 0){
+            break;
+        }
+        pos = pos->next;
+    }
+
+    list_insert_before(pos, &tcb->state_node);
+}
+
+
+
+/*
+ * Changes the priority of a task and reschedules at once: raising a
+ * ready task above the running one, or lowering the running task below
+ * a ready one, switches before this function returns. While the task
+ * holds a mutex it keeps running at least at the inherited priority.
+ * Returns 0 on success, -1 for an invalid handle or priority.
+ */
+int task_set_priority(task_handle_t task, task_priority_t task_priority){
+    if ((uint32_t)task_priority >= TASK_PRIORITY_LEVELS){
+        return -1;
+    }
+
+    CRITICAL_ENTER();
+
+    TCB_t *tcb = task_from_handle(task);
+
+    /* The idle task always keeps TASK_PRIORITY_IDLE */
+    if (!tcb || tcb == &tcb_pool[0]){
+        CRITICAL_EXIT();
+        return -1;
+    }
+
+    /* Keep any priority inherited through held mutexes */
+    tcb->base_priority = task_priority;
+    mutex_priority_update(tcb);
+
+    CRITICAL_EXIT();
+
+    return 0;
+}
+
+
+/*
+ * Sets how many ticks a task runs before the next task of its priority
+ * (or the next task under SCHED_RR) gets the CPU. A running task whose
+ * remaining slice is longer than the new one is cut to it.
+ * Returns -1 for an invalid handle or a slice outside 1..TASK_TIME_SLICE_MAX.
+ */
+int task_set_time_slice(task_handle_t task, uint32_t time_slice_ticks){
+    if (time_slice_ticks == 0 || time_slice_ticks > TASK_TIME_SLICE_MAX){
+        return -1;
+    }
+
+    CRITICAL_ENTER();
+
+    TCB_t *tcb = task_from_handle(task);
+    if (!tcb){
+        CRITICAL_EXIT();
+        return -1;
+    }
+
+    tcb->time_slice = (uint8_t)time_slice_ticks;
+    if (tcb->slice_left > tcb->time_slice){
+        tcb->slice_left = tcb->time_slice;
+    }
+
+    CRITICAL_EXIT();
+
+    return 0;
+}
+
+
+/*
+ * Declares a periodic task for SCHED_EDF: each job is released every
+ * period_ticks (task_delay_until()) and must finish within deadline_ticks
+ * of its release (0: the deadline is the period). The first job is
+ * released now. A period of 0 removes the deadline; under SCHED_EDF such
+ * tasks only run when no task with a deadline is ready.
+ * Returns -1 for an invalid handle, the idle task, or a deadline longer
+ * than the period.
+ */
+int task_set_deadline(task_handle_t task, uint32_t period_ticks, uint32_t deadline_ticks){
+    if (deadline_ticks > period_ticks){
+        return -1;
+    }
+
+    CRITICAL_ENTER();
+
+    TCB_t *tcb = task_from_handle(task);
+    if (!tcb || tcb == &tcb_pool[0]){
+        CRITICAL_EXIT();
+        return -1;
+    }
+
+    TCB_cold_t *cold = &tcb_cold[tcb - tcb_pool];
+
+    cold->period = period_ticks;
+    cold->rel_deadline = deadline_ticks ? deadline_ticks : period_ticks;
+    tcb->has_deadline = (period_ticks != 0);
+    tcb->deadline = g_tick_count + cold->rel_deadline;
+
+    if (tcb->state == TASK_STATE_READY){
+        ready_queue_remove(tcb);
+        ready_queue_insert(tcb);
+    }
+    scheduler_preempt_check();
+
+    CRITICAL_EXIT();
+
+    return 0;
+}
+
+
+/*
+ * Selects the scheduling policy. Round-robin and EDF queue every non-idle
+ * task on one ready list (EDF ordered by deadline), so the ready tasks
+ * are requeued here (O(tasks), outside any hot path). Set
+ * active_scheduler through this function.
+ */
+void scheduler_set_policy(sched_algo_t algo){
+    CRITICAL_ENTER();
+
+    active_scheduler = algo;
+    ready_queue_set_mode((algo == SCHED_RR)  ? READY_QUEUE_SINGLE :
+                         (algo == SCHED_EDF) ? READY_QUEUE_DEADLINE : READY_QUEUE_PRIORITY);
+
+    for (int i = 0; i < MAX_TASKS; i++){
+        if (tcb_pool[i].state == TASK_STATE_READY){
+            ready_queue_remove(&tcb_pool[i]);
+            ready_queue_insert(&tcb_pool[i]);
+        }
+    }
+
+    scheduler_preempt_check();
+
+    CRITICAL_EXIT();
+}
+
+
+/*
+ * Gives up the CPU voluntarily. The task stays READY and goes behind
+ * the other tasks of its priority (or to the next task in round-robin
+ * order); if no other task is eligible it simply continues.
+ */
+void task_yield(void){
+    CRITICAL_ENTER();
+
+    tcb_pool[current_task].slice_left = tcb_pool[current_task].time_slice;
+    ready_queue_rotate(&tcb_pool[current_task]);
+
+    if (scheduler_select_next_task() != current_task){
         schedule();
     }
 
-    INTERRUPT_ENABLE();
+    CRITICAL_EXIT();
 }
 
+/* ------------------------------------------------------------
+ * Kernel object support
+ * ------------------------------------------------------------ */
 
+TCB_t *scheduler_current_tcb(void){
+    return &tcb_pool[current_task];
+}
 
-void init_systick_timer(uint32_t tick_hz){
-    uint32_t reload;
 
-    /* Calculate reload value */
-    reload = (SYSTICK_TIM_CLK / tick_hz) - 1U;
+/*
+ * Blocks the running task on a kernel object's wait list, ordered by
+ * priority. wait_list may be NULL for waits that are not queued on an
+ * object (task notifications). With a timeout other than WAIT_FOREVER
+ * the task is also put on the delay list, and unblock_tasks() wakes it
+ * with WAIT_TIMEOUT.
+ *
+ * Must be called inside a kernel critical section (CRITICAL_ENTER). The switch happens
+ * at the caller's outermost CRITICAL_EXIT(); the caller then reads
+ * wait_status to see why it woke up.
+ */
+void scheduler_block_current(list_t *wait_list, uint32_t timeout_ticks){
+    TCB_t *tcb = &tcb_pool[current_task];
+
+    ready_queue_remove(tcb);
+    tcb->state = TASK_STATE_BLOCKED_OBJ;
+    tcb->wait_status = WAIT_TIMEOUT;
+    tcb->wait_list = wait_list;
+    if (wait_list){
+        wait_list_insert(wait_list, tcb);
+    }
+    TRACE_EVENT(TRACE_EVT_BLOCK, current_task, wait_list ? TRACE_BLOCK_OBJECT : TRACE_BLOCK_SIGNAL);
+
+    if (timeout_ticks != WAIT_FOREVER){
+        tcb->block_count = g_tick_count + timeout_ticks;
+        delay_list_insert(tcb);
+    }
 
-    /* Load reload value */
-    SYST_RVR = reload;
+    schedule();
+}
 
-    /* Clear current value register */
-    SYST_CVR = 0U;
 
-    /* Configure and start SysTick
-     * - Processor clock
-     * - Enable SysTick interrupt
-     * - Enable SysTick counter
-     */
-    SYST_CSR = SYST_CSR_CLKSOURCE | SYST_CSR_TICKINT  | SYST_CSR_ENABLE;
+/*
+ * Ends an object wait: takes the task off the wait list and, if it had
+ * a timeout, off the delay list, then makes it READY (preempting if it
+ * outranks the running task). Must be called inside a kernel critical section (CRITICAL_ENTER).
+ * Does nothing unless the task is blocked, so a stale waiter pointer
+ * can never resurrect a deleted task or requeue a ready one.
+ */
+void scheduler_wake(TCB_t *tcb, int8_t status){
+    if (tcb->state != TASK_STATE_BLOCKED && tcb->state != TASK_STATE_BLOCKED_OBJ){
+        return;
+    }
+
+    if (list_node_linked(&tcb->event_node)){
+        list_remove(&tcb->event_node);
+    }
+    if (list_node_linked(&tcb->state_node)){
+        list_remove(&tcb->state_node);
+    }
+
+    tcb->wait_list = NULL;
+    tcb->wait_status = status;
+    scheduler_make_ready(tcb);
 }
 
 
-void task_set_priority(uint8_t task, task_priority_t task_priority){
-    INTERRUPT_DISABLE();
-    tcb_pool[task].priority = task_priority;
-    INTERRUPT_ENABLE();
+/*
+ * Sets the effective priority of a task, keeping whichever queue it is
+ * on (ready list or object wait list) ordered. Used for priority
+ * inheritance; the base priority is left alone.
+ * Must be called inside a kernel critical section (CRITICAL_ENTER).
+ */
+void scheduler_set_priority(TCB_t *tcb, uint8_t priority){
+    if (tcb->state == TASK_STATE_READY){
+        ready_queue_remove(tcb);
+        tcb->priority = priority;
+        ready_queue_insert(tcb);
+    }else if (tcb->state == TASK_STATE_BLOCKED_OBJ && tcb->wait_list){
+        list_remove(&tcb->event_node);
+        tcb->priority = priority;
+        wait_list_insert(tcb->wait_list, tcb);
+    }else{
+        tcb->priority = priority;
+    }
+
+    scheduler_preempt_check();
 }
 
+
+/*
+ * Inserts a task into an object wait list behind every waiter of the
+ * same or higher priority, so the head is always the task to wake next
+ * and equal priorities are served in FIFO order.
+ */
+static void wait_list_insert(list_t *wait_list, TCB_t *tcb){
+    list_node_t *pos = wait_list->next;
+
+    while (pos != wait_list){
+        if (LIST_ENTRY(pos, TCB_t, event_node)->priority > tcb->priority){
+            break;
+        }
+        pos = pos->next;
+    }
+
+    list_insert_before(pos, &tcb->event_node);
+}
+
+
 /*
     * ---------------------------------------------------
     *               Scheduling Algorithms
@@ -276,38 +652,144 @@ void task_set_priority(uint8_t task, task_priority_t task_priority){
 */
 
 
+/*
+ * Task the active policy would run next, without switching to it or
+ * touching any statistics. Must be called inside a kernel critical
+ * section (CRITICAL_ENTER).
+ */
+uint16_t scheduler_select_next_task(void){
+    switch (active_scheduler)
+    {
+    case SCHED_RR:
+        return sched_rr_select_next_task();
+
+    case SCHED_PRIORITY:
+        return sched_priority_select_next_task();
+
+    case SCHED_EDF:
+        return sched_edf_select_next_task();
+
+    default:
+        return 0;
+    }
+}
+
+
 /*
  * Round-robin scheduling policy:
- * Selects the next READY task in cyclic order.
+ * Selects the next READY task in turn, ignoring priorities. In
+ * round-robin mode (scheduler_set_policy()) the ready queue holds every
+ * non-idle task on one list and the running task is rotated to its tail
+ * when its time slice runs out, so the head is the next task in O(1).
  * Task 0 (idle) is selected only if no user task is READY.
  */
-static uint8_t sched_rr_select_next_task(void){
-    task_state_t state = TASK_STATE_BLOCKED;
+static uint16_t sched_rr_select_next_task(void){
+    TCB_t *next = ready_queue_peek();
 
-    for (int i = 0; i < MAX_TASKS; i++){
-        current_task++;
-        current_task %= MAX_TASKS;
-        state = tcb_pool[current_task].state;
+    if (!next){
+        return 0; // idle task
+    }
+    return (uint16_t)(next - tcb_pool);
+}
 
-        if((state == TASK_STATE_READY) && (current_task != 0)){
-            return current_task;
-        }
+
+/*
+ * Priority scheduling policy:
+ * Selects the head of the highest non-empty ready list in O(1).
+ * Tasks of equal priority take turns because SysTick rotates the
+ * running task to the tail of its list at the end of its time slice. The idle task sits alone at
+ * TASK_PRIORITY_IDLE and is picked only if nothing else is READY.
+ */
+static uint16_t sched_priority_select_next_task(void){
+    TCB_t *next = ready_queue_peek();
+
+    if (!next){
+        return 0; // idle task
     }
-    return 0; // idle task
+    return (uint16_t)(next - tcb_pool);
 }
 
 
-static uint8_t sched_priority_select_next_task(void){
-    uint8_t selected = 0; // idle task by default
-    task_priority_t best_prio = TASK_PRIORITY_IDLE;
+/*
+ * Earliest-deadline-first scheduling policy:
+ * In EDF mode the ready queue keeps every non-idle task on one list
+ * ordered by absolute deadline (tasks without one last), so the head is
+ * the ready task with the nearest deadline, in O(1). Priorities are not
+ * used; tasks with equal deadlines take turns by time slice. The idle
+ * task is picked only if nothing else is READY.
+ */
+static uint16_t sched_edf_select_next_task(void){
+    TCB_t *next = ready_queue_peek();
 
-    for (int i = 1; i < MAX_TASKS; i++){
-        if(tcb_pool[i].state == TASK_STATE_READY){
-            if(tcb_pool[i].priority <= best_prio){
-                best_prio = tcb_pool[i].priority;
-                selected = i;
-            }
-        }
+    if (!next){
+        return 0; // idle task
+    }
+    return (uint16_t)(next - tcb_pool);
+}
+
+
+/*
+    * ---------------------------------------------------
+    *               Tickless idle
+    * ---------------------------------------------------
+*/
+
+#if TICKLESS_IDLE
+/*
+ * Number of ticks until the earliest delayed task wakes up, or
+ * UINT32_MAX if no task is delayed. Called in a critical section.
+ */
+static uint32_t ticks_until_next_wakeup(void){
+    list_node_t *node = list_first(&delay_list);
+
+    if (!node){
+        return UINT32_MAX;
+    }
+
+    int32_t remaining = (int32_t)(LIST_ENTRY(node, TCB_t, state_node)->block_count - g_tick_count);
+    return (remaining > 0) ? (uint32_t)remaining : 0U;
+}
+#endif /* TICKLESS_IDLE */
+
+
+/*
+ * scheduler_idle_sleep
+ * --------------------
+ * Called in a loop by the idle task.
+ *
+ * If the idle task is the only runnable task and the next wake-up (task
+ * delay or software timer) is at least TICKLESS_MIN_IDLE_TICKS away, the port suppresses the tick until
+ * that wake-up and puts the core to sleep. The ticks that passed while
+ * asleep are then added to g_tick_count before interrupts are enabled
+ * again, so pending handlers see the corrected time.
+ */
+void scheduler_idle_sleep(void){
+#if TICKLESS_IDLE
+    CRITICAL_ENTER();
+
+    /* Another task shares the idle priority: don't sleep through its turn */
+    if (!ready_queue_is_only(&tcb_pool[current_task])){
+        CRITICAL_EXIT();
+        return;
+    }
+
+    uint32_t expected = ticks_until_next_wakeup();
+    uint32_t timer_expected = soft_timer_ticks_until_next();
+    if (timer_expected < expected){
+        expected = timer_expected;
     }
-    return selected;
+
+    /* Too short to be worth reprogramming the timer: sleep until the next tick */
+    if (expected < TICKLESS_MIN_IDLE_TICKS){
+        CRITICAL_EXIT();
+        port_wait_for_interrupt();
+        return;
+    }
+
+    g_tick_count += port_tickless_sleep(expected);
+
+    CRITICAL_EXIT();
+#else
+    port_wait_for_interrupt();
+#endif
 }
@@ -0,0 +1,74 @@
+#include "semaphore.h"
+#include "cpu_defs.h"
+#include "scheduler.h"
+
+
+extern TCB_t tcb_pool[MAX_TASKS];
+
+
+int sem_init(semaphore_t *sem, uint32_t initial_count, uint32_t max_count){
+    if (max_count == 0 || initial_count > max_count){
+        return -1;
+    }
+
+    sem->count = initial_count;
+    sem->max_count = max_count;
+    list_init(&sem->waiters);
+
+    return 0;
+}
+
+
+int sem_take(semaphore_t *sem, uint32_t timeout_ticks){
+    CRITICAL_ENTER();
+
+    if (sem->count){
+        sem->count--;
+        CRITICAL_EXIT();
+        return 0;
+    }
+
+    TCB_t *self = scheduler_current_tcb();
+
+    /* The idle task must never block */
+    if (timeout_ticks == 0 || self == &tcb_pool[0]){
+        CRITICAL_EXIT();
+        return -1;
+    }
+
+    scheduler_block_current(&sem->waiters, timeout_ticks);
+
+    CRITICAL_EXIT();
+
+    /* Switched out here until sem_give() or the timeout wakes us */
+
+    return (self->wait_status == WAIT_OK) ? 0 : -1;
+}
+
+
+int sem_give(semaphore_t *sem){
+    CRITICAL_ENTER();
+
+    /* A waiter gets the unit directly; the count stays at 0 */
+    list_node_t *node = list_first(&sem->waiters);
+    if (node){
+        scheduler_wake(LIST_ENTRY(node, TCB_t, event_node), WAIT_OK);
+        CRITICAL_EXIT();
+        return 0;
+    }
+
+    if (sem->count >= sem->max_count){
+        CRITICAL_EXIT();
+        return -1;
+    }
+    sem->count++;
+
+    CRITICAL_EXIT();
+
+    return 0;
+}
+
+
+uint32_t sem_count(const semaphore_t *sem){
+    return sem->count;
+}
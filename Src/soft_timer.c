@@ -0,0 +1,246 @@
+#include "soft_timer.h"
+#include "cpu_defs.h"
+#include "scheduler.h"
+
+
+extern uint32_t g_tick_count;
+
+/* Running timers, earliest expiry at index 0 */
+static soft_timer_t *timer_heap[SOFT_TIMER_MAX];
+static uint16_t timer_count = 0;
+
+static task_handle_t service_task = TASK_HANDLE_INVALID;
+
+/*
+ * Holds the service task while it waits for the next expiry. A wait
+ * list rather than a TCB pointer, so task_delete() unlinks it.
+ */
+static list_t service_wait = { &service_wait, &service_wait };
+
+
+/* ------------------------------------------------------------
+ * Timer heap (inside a kernel critical section)
+ * ------------------------------------------------------------ */
+
+/* a expires before b (overflow safe, like the delay list) */
+static inline int expires_before(const soft_timer_t *a, const soft_timer_t *b){
+    return (int32_t)(a->expiry - b->expiry) < 0;
+}
+
+static inline void heap_place(soft_timer_t *timer, uint16_t index){
+    timer_heap[index] = timer;
+    timer->heap_index = (int16_t)index;
+}
+
+static void heap_sift_up(uint16_t index){
+    soft_timer_t *timer = timer_heap[index];
+
+    while (index > 0){
+        uint16_t parent = (uint16_t)((index - 1U) / 2U);
+
+        if (!expires_before(timer, timer_heap[parent])){
+            break;
+        }
+        heap_place(timer_heap[parent], index);
+        index = parent;
+    }
+    heap_place(timer, index);
+}
+
+static void heap_sift_down(uint16_t index){
+    soft_timer_t *timer = timer_heap[index];
+
+    while (1){
+        uint16_t child = (uint16_t)(2U * index + 1U);
+
+        if (child >= timer_count){
+            break;
+        }
+        if (child + 1U < timer_count && expires_before(timer_heap[child + 1U], timer_heap[child])){
+            child++;
+        }
+        if (!expires_before(timer_heap[child], timer)){
+            break;
+        }
+        heap_place(timer_heap[child], index);
+        index = child;
+    }
+    heap_place(timer, index);
+}
+
+static void heap_insert(soft_timer_t *timer){
+    heap_place(timer, timer_count++);
+    heap_sift_up((uint16_t)timer->heap_index);
+}
+
+static void heap_remove(soft_timer_t *timer){
+    uint16_t index = (uint16_t)timer->heap_index;
+    soft_timer_t *last = timer_heap[--timer_count];
+
+    timer->heap_index = -1;
+    if (last == timer){
+        return;
+    }
+
+    /* Move the last timer into the hole and restore the heap order */
+    heap_place(last, index);
+    if (index > 0 && expires_before(last, timer_heap[(index - 1U) / 2U])){
+        heap_sift_up(index);
+    }else{
+        heap_sift_down(index);
+    }
+}
+
+/* Heap head if it has expired, otherwise NULL */
+static inline soft_timer_t *heap_due(void){
+    if (timer_count == 0 || (int32_t)(g_tick_count - timer_heap[0]->expiry) < 0){
+        return NULL;
+    }
+    return timer_heap[0];
+}
+
+
+/* ------------------------------------------------------------
+ * Timer-service task
+ * ------------------------------------------------------------ */
+
+/*
+ * Wake the service task if the head is due.
+ * Must be called inside a kernel critical section (CRITICAL_ENTER).
+ */
+static void service_wake_if_due(void){
+    list_node_t *node = list_first(&service_wait);
+
+    if (node && heap_due()){
+        scheduler_wake(LIST_ENTRY(node, TCB_t, event_node), WAIT_OK);
+    }
+}
+
+
+/*
+ * Runs every expired timer, then sleeps until the tick (or a start of an
+ * already expired timer) wakes it. Auto-reload timers are rescheduled
+ * from their previous expiry, not from now, so they do not drift when
+ * the service task runs late.
+ */
+static void timer_service_task(void *arg){
+    (void)arg;
+
+    while (1){
+        CRITICAL_ENTER();
+
+        soft_timer_t *timer;
+        while ((timer = heap_due()) != NULL){
+            soft_timer_fn_t callback = timer->callback;
+            void *callback_arg = timer->arg;
+
+            heap_remove(timer);
+            if (timer->period){
+                timer->expiry += timer->period;
+                heap_insert(timer);
+            }
+
+            CRITICAL_EXIT();
+            callback(callback_arg);
+            CRITICAL_ENTER();
+        }
+
+        scheduler_block_current(&service_wait, WAIT_FOREVER);
+
+        CRITICAL_EXIT();
+
+        /* Switched out here until a timer is due */
+    }
+}
+
+
+int soft_timer_service_start(uint32_t stack_size, task_priority_t priority){
+    /* One service task; a deleted one may be started again */
+    if (task_from_handle(service_task)){
+        return -1;
+    }
+
+    task_handle_t handle = task_create(timer_service_task, NULL, stack_size, priority);
+    if (handle == TASK_HANDLE_INVALID){
+        return -1;
+    }
+
+    service_task = handle;
+
+    return 0;
+}
+
+
+/* ------------------------------------------------------------
+ * Timer API
+ * ------------------------------------------------------------ */
+
+void soft_timer_init(soft_timer_t *timer, soft_timer_fn_t callback, void *arg){
+    timer->expiry = 0;
+    timer->period = 0;
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->heap_index = -1;
+}
+
+
+int soft_timer_start(soft_timer_t *timer, uint32_t delay_ticks, uint32_t period_ticks){
+    CRITICAL_ENTER();
+
+    if (timer->heap_index >= 0){
+        heap_remove(timer);
+    }else if (timer_count >= SOFT_TIMER_MAX){
+        CRITICAL_EXIT();
+        return -1;
+    }
+
+    timer->expiry = g_tick_count + delay_ticks;
+    timer->period = period_ticks;
+    heap_insert(timer);
+
+    /* A delay of 0 runs at once instead of at the next tick */
+    service_wake_if_due();
+
+    CRITICAL_EXIT();
+
+    return 0;
+}
+
+
+int soft_timer_stop(soft_timer_t *timer){
+    CRITICAL_ENTER();
+
+    if (timer->heap_index < 0){
+        CRITICAL_EXIT();
+        return -1;
+    }
+    heap_remove(timer);
+
+    CRITICAL_EXIT();
+
+    return 0;
+}
+
+
+int soft_timer_active(const soft_timer_t *timer){
+    return timer->heap_index >= 0;
+}
+
+
+/*
+ * Called from scheduler_tick(). Only the heap head is compared, so the
+ * cost per tick does not depend on the number of running timers.
+ */
+void soft_timer_tick(void){
+    service_wake_if_due();
+}
+
+
+uint32_t soft_timer_ticks_until_next(void){
+    if (timer_count == 0){
+        return UINT32_MAX;
+    }
+
+    int32_t remaining = (int32_t)(timer_heap[0]->expiry - g_tick_count);
+    return (remaining > 0) ? (uint32_t)remaining : 0U;
+}
@@ -0,0 +1,123 @@
+#include "regs.h"
+#include "cpu_defs.h"
+#include "system.h"
+
+/* Main PLL: VCO input 1 MHz, VCO 336 MHz, SYSCLK 168 MHz, PLL48CK 48 MHz */
+#define PLL_M_HSE               (HSE_VALUE / 1000000U)
+#define PLL_M_HSI               (HSI_VALUE / 1000000U)
+#define PLL_N                   336U
+#define PLL_P                   2U
+#define PLL_Q                   7U
+
+/* Flash wait states for 150-168 MHz at 2.7-3.6 V */
+#define FLASH_WAIT_STATES       5U
+
+/* Bounded waits, so a missing crystal or an emulator without RCC still boots */
+#define HSE_STARTUP_TIMEOUT     0x10000U
+#define PLL_LOCK_TIMEOUT        0x10000U
+
+
+static int wait_for(volatile uint32_t *reg, uint32_t mask, uint32_t value, uint32_t timeout){
+    while ((*reg & mask) != value){
+        if (timeout-- == 0){
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+/* HSE, PLL, flash wait states and ART, then switch SYSCLK to the PLL */
+static void clock_init(void){
+    uint32_t pll_source = RCC_PLLCFGR_PLLSRC_HSE | RCC_PLLCFGR_PLLM(PLL_M_HSE);
+
+    RCC_CR |= RCC_CR_HSEON;
+    if (wait_for(&RCC_CR, RCC_CR_HSERDY, RCC_CR_HSERDY, HSE_STARTUP_TIMEOUT)){
+        RCC_CR &= ~RCC_CR_HSEON;
+        pll_source = RCC_PLLCFGR_PLLM(PLL_M_HSI);
+    }
+
+    /* Regulator scale 1 for more than 144 MHz */
+    RCC_APB1ENR |= RCC_APB1ENR_PWREN;
+    PWR_CR |= PWR_CR_VOS;
+
+    /* AHB /1, APB1 /4 (42 MHz max), APB2 /2 (84 MHz max) */
+    RCC_CFGR = (RCC_CFGR & ~(RCC_CFGR_HPRE_MASK | RCC_CFGR_PPRE_MASK)) |
+               RCC_CFGR_PPRE1_DIV4 | RCC_CFGR_PPRE2_DIV2;
+
+    RCC_PLLCFGR = (RCC_PLLCFGR & ~RCC_PLLCFGR_MASK) | pll_source | RCC_PLLCFGR_PLLN(PLL_N) |
+                  RCC_PLLCFGR_PLLP(PLL_P) | RCC_PLLCFGR_PLLQ(PLL_Q);
+    RCC_CR |= RCC_CR_PLLON;
+
+    /* Flush the ART caches (they are disabled out of reset), then enable them */
+    FLASH_ACR = FLASH_ACR_ICRST | FLASH_ACR_DCRST;
+    FLASH_ACR = FLASH_ACR_PRFTEN | FLASH_ACR_ICEN | FLASH_ACR_DCEN;
+
+    if (wait_for(&RCC_CR, RCC_CR_PLLRDY, RCC_CR_PLLRDY, PLL_LOCK_TIMEOUT)){
+        return;     // stay on the HSI
+    }
+
+    /* Wait states must be in place before the clock goes up */
+    FLASH_ACR = FLASH_ACR_PRFTEN | FLASH_ACR_ICEN | FLASH_ACR_DCEN | FLASH_ACR_LATENCY(FLASH_WAIT_STATES);
+    (void)wait_for(&FLASH_ACR, FLASH_ACR_LATENCY(7U), FLASH_ACR_LATENCY(FLASH_WAIT_STATES), PLL_LOCK_TIMEOUT);
+
+    RCC_CFGR = (RCC_CFGR & ~RCC_CFGR_SW_MASK) | RCC_CFGR_SW_PLL;
+    (void)wait_for(&RCC_CFGR, RCC_CFGR_SWS_MASK, RCC_CFGR_SWS_PLL, PLL_LOCK_TIMEOUT);
+}
+
+
+/*
+ * SystemInit
+ * ----------
+ * Called by Reset_Handler before .data and .bss are initialised,
+ * so it must not rely on global variables.
+ */
+void SystemInit(void){
+#if PORT_HAS_FPU
+    /*
+     * Give thread and handler mode full access to the FPU, and keep
+     * automatic + lazy FP state preservation on: an exception only
+     * reserves space for S0-S15 and they are stacked on first FP use
+     * in the handler (or by PendSV's VSTM of S16-S31).
+     */
+    SCB_CPACR |= SCB_CPACR_CP10_CP11_FULL;
+    FPU_FPCCR |= FPU_FPCCR_ASPEN | FPU_FPCCR_LSPEN;
+
+    __asm volatile("DSB \n ISB" ::: "memory");
+#endif
+
+    clock_init();
+}
+
+
+/*
+ * Derived from the RCC registers rather than stored, so it is correct
+ * whatever clock_init() managed to set up and even before .data exists.
+ */
+uint32_t system_core_clock(void){
+    static const uint8_t ahb_shift[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 6, 7, 8, 9 };
+    uint32_t sysclk;
+
+    switch (RCC_CFGR & RCC_CFGR_SWS_MASK){
+    case RCC_CFGR_SWS_HSE:
+        sysclk = HSE_VALUE;
+        break;
+
+    case RCC_CFGR_SWS_PLL: {
+        uint32_t pllcfgr = RCC_PLLCFGR;
+        uint32_t source = (pllcfgr & RCC_PLLCFGR_PLLSRC_HSE) ? HSE_VALUE : HSI_VALUE;
+        uint32_t m = pllcfgr & 0x3FU;
+        uint32_t n = (pllcfgr >> 6) & 0x1FFU;
+        uint32_t p = (((pllcfgr >> 16) & 0x3U) + 1U) * 2U;
+
+        sysclk = (m != 0U) ? (source / m) * n / p : HSI_VALUE;
+        break;
+    }
+
+    default:
+        sysclk = HSI_VALUE;
+        break;
+    }
+
+    return sysclk >> ahb_shift[(RCC_CFGR & RCC_CFGR_HPRE_MASK) >> 4];
+}
@@ -2,92 +2,208 @@
 #include "cpu_defs.h"
 #include "led.h"
 #include "main.h"
+#include "ready_queue.h"
+#include "scheduler.h"
+#include "notify.h"
+#include "block_pool.h"
+#include "mutex.h"
+#include "port.h"
+#include "trace.h"
 
 
-static uint8_t rtos_heap[RTOS_HEAP_SIZE];
+/* Stack size classes: STACK_CLASS_MIN << n bytes, n < STACK_CLASS_COUNT */
+#define STACK_CLASS_MIN     128U
+#define STACK_CLASS_COUNT   7U          // 128 B .. 8 KB
+
+/*
+ * Every stack starts at a multiple of STACK_CLASS_MIN, which keeps it
+ * aligned for the port's stack guard. The lowest PORT_STACK_GUARD_SIZE
+ * bytes of each stack are the guard and must never be written.
+ */
+static uint8_t rtos_heap[RTOS_HEAP_SIZE] PORT_FAST_BSS __attribute__((aligned(STACK_CLASS_MIN)));
 static uint32_t heap_offset = 0;
-TCB_t tcb_pool[MAX_TASKS];
+static uint8_t *stack_free_lists[STACK_CLASS_COUNT];
+
+/* Message blocks, carved into msg_pool by task_init() */
+static uint8_t msg_pool_storage[MSG_POOL_BLOCK_COUNT * MSG_POOL_BLOCK_SIZE] __attribute__((aligned(8)));
+block_pool_t msg_pool;
+
+TCB_t tcb_pool[MAX_TASKS] PORT_FAST_BSS;
+TCB_cold_t tcb_cold[MAX_TASKS];
+
+/* Unused task slots (linked through state_node), so task_create() is O(1) */
+static list_t free_tcbs;
+
+_Static_assert(MAX_TASKS >= 2 && MAX_TASKS <= 0x10000, "MAX_TASKS must fit the 16-bit slot of a task handle");
 
 
 
 void task_init(void){
+#if TRACE_ENABLE
+    trace_init();
+#endif
+    list_init(&free_tcbs);
+
     for (int i = 0; i < MAX_TASKS; i++){
         tcb_pool[i].state = TASK_STATE_UNUSED;
+        tcb_pool[i].generation = 1;
+        list_node_init(&tcb_pool[i].state_node);
+        list_node_init(&tcb_pool[i].event_node);
+        list_init(&tcb_pool[i].mutexes_held);
+        tcb_pool[i].wait_list = NULL;
+        tcb_pool[i].wait_mutex = NULL;
+        tcb_pool[i].notify_value = 0;
+        tcb_pool[i].notify_state = NOTIFY_STATE_IDLE;
+
+        if (i){     // slot 0 is reserved for the idle task
+            list_push_back(&free_tcbs, &tcb_pool[i].state_node);
+        }
+    }
+    ready_queue_init();
+    block_pool_init(&msg_pool, msg_pool_storage, MSG_POOL_BLOCK_SIZE, MSG_POOL_BLOCK_COUNT);
+}
+
+/*
+ * Stacks come in power-of-two size classes (STACK_CLASS_MIN bytes and
+ * up). A freed stack goes onto the free list of its class, with the link
+ * stored in the block itself (above the guard), and is reused by the next request of that
+ * class before any new memory is taken from rtos_heap.
+ */
+static uint32_t stack_class(uint32_t size_bytes){
+    uint32_t cls = 0;
+
+    while ((STACK_CLASS_MIN << cls) < size_bytes){
+        cls++;
     }
+    return cls;
 }
 
-static uint8_t *alloc_stack(uint32_t size_bytes){
-    /* 8 byte alignmemnt */
-    size_bytes = (size_bytes + 7) & ~0x7;
-    if(heap_offset + size_bytes > RTOS_HEAP_SIZE){
+/* Allocates a stack of at least *size_bytes and stores the size actually reserved */
+static uint8_t *alloc_stack(uint32_t *size_bytes){
+    uint32_t cls = stack_class(*size_bytes);
+
+    if (cls >= STACK_CLASS_COUNT){
         return NULL;
     }
-    uint8_t *ptr = &rtos_heap[heap_offset];
-    heap_offset += size_bytes;
 
+    uint32_t class_size = STACK_CLASS_MIN << cls;
+    uint8_t *ptr = stack_free_lists[cls];
+
+    if (ptr){
+        stack_free_lists[cls] = *(uint8_t **)(ptr + PORT_STACK_GUARD_SIZE);
+    }else{
+        if(heap_offset + class_size > RTOS_HEAP_SIZE){
+            return NULL;
+        }
+        ptr = &rtos_heap[heap_offset];
+        heap_offset += class_size;
+    }
+
+    *size_bytes = class_size;
     return ptr;
 }
 
+/* size_bytes must be the size returned by alloc_stack() */
+static void free_stack(uint8_t *stack, uint32_t size_bytes){
+    uint32_t cls = stack_class(size_bytes);
 
-static uint32_t *build_initial_stack(uint8_t *stack_base, uint32_t stack_size, task_func_t entry, void *arg){
-    uint32_t *pPSP = (uint32_t *) (stack_base + stack_size);
+    /* Not in the guard: a task deleting itself still has its guard active */
+    *(uint8_t **)(stack + PORT_STACK_GUARD_SIZE) = stack_free_lists[cls];
+    stack_free_lists[cls] = stack;
+}
 
-    /* 8-byte alignment (ABI requiremnt) */
-    pPSP = (uint32_t *) ((uint32_t)pPSP & ~0x7);
 
-    /* Cortex-M uses a full-descending stack so we first need to decrement the pointer the updates the value */
+task_handle_t task_handle_of(const TCB_t *tcb){
+    uint32_t slot = (uint32_t)(tcb - tcb_pool);
 
-    *(--pPSP) = DUMMY_XPSR;                     // xPSR
-    *(--pPSP) = ((uint32_t)entry) | 1;          // PC
-    *(--pPSP) = EXC_RETURN_THREAD_PSP_NOFP;     // LR (EXC_RETURN, PSP)
-    *(--pPSP) = 0;                              // R12
-    *(--pPSP) = 0;                              // R3
-    *(--pPSP) = 0;                              // R2
-    *(--pPSP) = 0;                              // R1
-    *(--pPSP) = (uint32_t)arg;                  // R0 (argument)
+    return (task_handle_t)(((uint32_t)tcb->generation << 16) | slot);
+}
+
+
+TCB_t *task_from_handle(task_handle_t task){
+    uint32_t slot = (uint32_t)task & 0xFFFFU;
 
-    for (int i = 0; i < 8; i++){
-        *(--pPSP) = 0;                          // R4-R11
+    if (task < 0 || slot >= MAX_TASKS){
+        return NULL;
     }
 
-    return pPSP;
-    
+    TCB_t *tcb = &tcb_pool[slot];
+
+    if (tcb->state == TASK_STATE_UNUSED || tcb->generation != ((uint32_t)task >> 16)){
+        return NULL;
+    }
+    return tcb;
 }
 
 
-int task_create(void (*task_fn)(void *), void *arg, uint32_t stack_size_bytes, task_priority_t priority){
-    if (!task_fn || stack_size_bytes < 64){
-        return -1;
-    }
-    INTERRUPT_DISABLE();
+task_handle_t task_self(void){
+    return task_handle_of(scheduler_current_tcb());
+}
+
 
-    for (int i = 1; i < MAX_TASKS; i++){    // 0 idle task
-        if(tcb_pool[i].state == TASK_STATE_UNUSED){
-            uint8_t *stack = alloc_stack(stack_size_bytes);
-            if(!stack){
-                INTERRUPT_ENABLE();
-                return -1;          // memory not allocated
-            }
+task_handle_t task_create(void (*task_fn)(void *), void *arg, uint32_t stack_size_bytes, task_priority_t priority){
+    return task_create_sliced(task_fn, arg, stack_size_bytes, priority, TASK_TIME_SLICE_DEFAULT);
+}
 
-            TCB_t *tcb = &tcb_pool[i];
-            
-            tcb->stack_base = stack;
-            tcb->stack_size = stack_size_bytes;
-            tcb->priority = priority;
-            tcb->entry = task_fn;
-            tcb->arg = arg;
-            tcb->state = TASK_STATE_READY;
-            tcb->block_count = 0;
 
-            tcb->psp = build_initial_stack(stack, stack_size_bytes, task_fn, arg);
+task_handle_t task_create_sliced(void (*task_fn)(void *), void *arg, uint32_t stack_size_bytes,
+                                 task_priority_t priority, uint32_t time_slice_ticks){
+    if (!task_fn || stack_size_bytes < 64 || (uint32_t)priority >= TASK_PRIORITY_LEVELS ||
+        time_slice_ticks == 0 || time_slice_ticks > TASK_TIME_SLICE_MAX){
+        return TASK_HANDLE_INVALID;
+    }
+    CRITICAL_ENTER();
 
-            INTERRUPT_ENABLE();
+    list_node_t *node = list_first(&free_tcbs);
+    if (!node){
+        CRITICAL_EXIT();
+        return TASK_HANDLE_INVALID;     // no free slot
+    }
 
-            return i;       // task handle
-        }
+    uint8_t *stack = alloc_stack(&stack_size_bytes);
+    if(!stack){
+        CRITICAL_EXIT();
+        return TASK_HANDLE_INVALID;     // memory not allocated
     }
-    INTERRUPT_ENABLE();
-    return -1;
+
+    list_remove(node);
+
+    TCB_t *tcb = LIST_ENTRY(node, TCB_t, state_node);
+    TCB_cold_t *cold = &tcb_cold[tcb - tcb_pool];
+
+    tcb->stack_base = stack;
+    cold->stack_size = stack_size_bytes;
+    tcb->priority = priority;
+    tcb->base_priority = priority;
+    cold->entry = task_fn;
+    cold->arg = arg;
+    tcb->block_count = 0;
+    tcb->notify_value = 0;
+    tcb->notify_state = NOTIFY_STATE_IDLE;
+    tcb->time_slice = (uint8_t)time_slice_ticks;
+    tcb->slice_left = (uint8_t)time_slice_ticks;
+    tcb->has_deadline = 0;
+    tcb->deadline = 0;
+    cold->period = 0;
+    cold->rel_deadline = 0;
+#if RUNTIME_STATS
+    tcb->run_cycles = 0;
+    tcb->switch_count = 0;
+    cold->run_cycles_mark = 0;
+    cold->switch_count_mark = 0;
+#endif
+
+    tcb->psp = port_init_stack(stack, stack_size_bytes, task_fn, arg);
+
+    task_handle_t handle = task_handle_of(tcb);
+    TRACE_EVENT(TRACE_EVT_CREATE, tcb - tcb_pool, priority);
+
+    /* A task created at a higher priority runs right away */
+    scheduler_make_ready(tcb);
+
+    CRITICAL_EXIT();
+
+    return handle;
 }
 
 
@@ -96,28 +212,109 @@ int task_create_idle(void (*task_fn)(void *), void *arg, uint32_t stack_size_byt
         return -1;
     }
 
-    INTERRUPT_DISABLE();
+    CRITICAL_ENTER();
 
     TCB_t *tcb = &tcb_pool[0];
+    TCB_cold_t *cold = &tcb_cold[0];
     
-    uint8_t *stack = alloc_stack(stack_size_bytes);
+    uint8_t *stack = alloc_stack(&stack_size_bytes);
     if(!stack){
-        INTERRUPT_ENABLE();
+        CRITICAL_EXIT();
         return -1;
     }
 
     tcb->stack_base = stack;
-    tcb->stack_size = stack_size_bytes;
+    cold->stack_size = stack_size_bytes;
     tcb->priority = TASK_PRIORITY_IDLE;
-    tcb->entry = task_fn;
-    tcb->arg = arg;
+    tcb->base_priority = TASK_PRIORITY_IDLE;
+    cold->entry = task_fn;
+    cold->arg = arg;
     tcb->state = TASK_STATE_READY;
     tcb->block_count = 0;
+    tcb->time_slice = TASK_TIME_SLICE_DEFAULT;
+    tcb->slice_left = TASK_TIME_SLICE_DEFAULT;
+    tcb->has_deadline = 0;
 
-    tcb->psp = build_initial_stack(stack, stack_size_bytes, task_fn, arg);
+    tcb->psp = port_init_stack(stack, stack_size_bytes, task_fn, arg);
+    ready_queue_insert(tcb);
+    TRACE_EVENT(TRACE_EVT_CREATE, 0U, TASK_PRIORITY_IDLE);
 
-    INTERRUPT_ENABLE();
+    CRITICAL_EXIT();
 
     return 0;
 }
 
+
+/*
+ * Deletes a task: it is taken off whatever list it is on (ready, delay
+ * or an object wait list), releases the mutexes it holds and its stack
+ * goes back to the stack pool. Its handle, and every copy of it, goes
+ * stale. Deleting the calling task does not return.
+ * Returns -1 for the idle task or a stale/invalid handle.
+ */
+int task_delete(task_handle_t task){
+    CRITICAL_ENTER();
+
+    TCB_t *tcb = task_from_handle(task);
+
+    if (!tcb || tcb == &tcb_pool[0]){
+        CRITICAL_EXIT();
+        return -1;
+    }
+
+    if (tcb->state == TASK_STATE_READY){
+        ready_queue_remove(tcb);
+    }else if (list_node_linked(&tcb->state_node)){
+        list_remove(&tcb->state_node);      // delay list
+    }
+
+    if (list_node_linked(&tcb->event_node)){
+        list_remove(&tcb->event_node);
+    }
+    tcb->wait_list = NULL;
+
+    /* The owner of the mutex it waited for no longer needs its priority */
+    if (tcb->wait_mutex){
+        TCB_t *owner = tcb->wait_mutex->owner;
+
+        tcb->wait_mutex = NULL;
+        mutex_priority_update(owner);
+    }
+    mutex_release_all(tcb);
+
+    /*
+     * A task deleting itself keeps running on the freed stack until the
+     * pended switch below, which happens as soon as interrupts are
+     * enabled again and before any task can allocate the stack.
+     */
+    TRACE_EVENT(TRACE_EVT_DELETE, tcb - tcb_pool, 0U);
+    tcb->state = TASK_STATE_UNUSED;
+    tcb->generation = (tcb->generation % TASK_GENERATION_MAX) + 1;
+    free_stack(tcb->stack_base, tcb_cold[tcb - tcb_pool].stack_size);
+    port_release_context(tcb->psp);
+
+    /* Reused last, so a stale handle keeps failing for as long as possible */
+    list_push_back(&free_tcbs, &tcb->state_node);
+
+    if (tcb == scheduler_current_tcb()){
+        schedule();
+    }else{
+        scheduler_preempt_check();
+    }
+
+    CRITICAL_EXIT();
+
+    return 0;
+}
+
+
+/*
+ * Ends the calling task. The initial stack frame of every task returns
+ * here, so a task function may simply return.
+ */
+void task_exit(void){
+    task_delete(task_self());
+
+    /* Not reached: the switch away from this task happens in task_delete() */
+    while(1);
+}
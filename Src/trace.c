@@ -0,0 +1,20 @@
+#include "trace.h"
+#include "cpu_defs.h"
+
+#if TRACE_ENABLE
+
+_Static_assert((TRACE_BUFFER_EVENTS & (TRACE_BUFFER_EVENTS - 1U)) == 0, "TRACE_BUFFER_EVENTS must be a power of two");
+
+trace_buffer_t trace_buffer = {
+    .magic = TRACE_MAGIC,
+    .capacity = TRACE_BUFFER_EVENTS,
+};
+
+
+void trace_init(void){
+    trace_buffer.head = 0;
+    port_init_runtime_counter();
+    trace_buffer.counter_hz = port_runtime_counter_hz();
+}
+
+#endif /* TRACE_ENABLE */
@@ -0,0 +1,315 @@
+/*
+ * Kernel behaviour tests (POSIX port)
+ * -----------------------------------
+ * Each scenario runs the real scheduler in its own process, selected by
+ * the first argument, and exits with 0 on success or 1 after printing
+ * the first failed check:
+ *
+ *   kernel-test delay       task_delay() timing and wake-up order
+ *   kernel-test mutex_pi    mutex priority inheritance
+ *   kernel-test delete      deleting running, delayed and blocked tasks
+ *
+ * Built by Port/Posix/CMakeLists.txt as kernel-test and registered with
+ * ctest once per scenario.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_defs.h"
+#include "tasks.h"
+#include "scheduler.h"
+#include "mutex.h"
+#include "semaphore.h"
+#include "ring_buffer.h"
+
+#define TEST_STACK_SIZE     512U
+
+#define CHECK(cond) do{ if (!(cond)){ test_fail(#cond, __LINE__); } } while (0)
+
+
+extern volatile uint32_t g_tick_count;
+extern TCB_t tcb_pool[MAX_TASKS];
+
+
+static void test_fail(const char *what, int line){
+    printf("FAIL line %d: %s\n", line, what);
+    fflush(stdout);
+    exit(EXIT_FAILURE);
+}
+
+
+static void test_pass(const char *name){
+    printf("PASS %s\n", name);
+    fflush(stdout);
+    exit(EXIT_SUCCESS);
+}
+
+
+static void idle_task(void *arg){
+    (void)arg;
+
+    while(1){
+        scheduler_idle_sleep();
+    }
+}
+
+
+/* ------------------------------------------------------------
+ * delay: each task wakes after its own delay, in wake-up order
+ * ------------------------------------------------------------ */
+
+#define DELAY_TASKS     3
+
+static volatile uint32_t wake_tick[DELAY_TASKS];
+static volatile uint32_t wake_order[DELAY_TASKS];
+static volatile uint32_t wakes = 0;
+
+static void delay_task(void *arg){
+    uint32_t index = (uint32_t)(uintptr_t)arg;
+    uint32_t start = g_tick_count;
+
+    /* Longest delay first, so the delay list has to order them */
+    task_delay((DELAY_TASKS - index) * 10U);
+
+    wake_tick[index] = g_tick_count - start;
+    wake_order[wakes++] = index;
+}
+
+static void delay_main(void *arg){
+    (void)arg;
+
+    for (uint32_t i = 0; i < DELAY_TASKS; i++){
+        task_create(delay_task, (void *)(uintptr_t)i, TEST_STACK_SIZE, TASK_PRIORITY_MEDIUM);
+    }
+
+    task_delay(DELAY_TASKS * 10U + 5U);
+
+    CHECK(wakes == DELAY_TASKS);
+    for (uint32_t i = 0; i < DELAY_TASKS; i++){
+        uint32_t expected = (DELAY_TASKS - i) * 10U;
+
+        CHECK(wake_tick[i] >= expected && wake_tick[i] <= expected + 1U);
+        CHECK(wake_order[i] == DELAY_TASKS - 1U - i);
+    }
+
+    /* A zero delay returns at once */
+    uint32_t before = g_tick_count;
+    task_delay(0);
+    CHECK(g_tick_count - before <= 1U);
+
+    test_pass("delay");
+}
+
+
+/* ------------------------------------------------------------
+ * mutex_pi: a low priority owner inherits the priority of a high
+ * priority waiter, so a medium task cannot hold the waiter up
+ * ------------------------------------------------------------ */
+
+static mutex_t pi_mutex;
+static TCB_t *low_tcb;
+static volatile int low_done = 0;
+static volatile int medium_ran_before_high = 0;
+static volatile int high_got_mutex = 0;
+
+static void pi_high(void *arg){
+    (void)arg;
+
+    CHECK(mutex_lock(&pi_mutex, WAIT_FOREVER) == 0);
+    CHECK(low_done);
+    high_got_mutex = 1;
+    CHECK(mutex_unlock(&pi_mutex) == 0);
+}
+
+static void pi_medium(void *arg){
+    (void)arg;
+
+    if (!high_got_mutex){
+        medium_ran_before_high = 1;
+    }
+}
+
+static void pi_low(void *arg){
+    (void)arg;
+
+    CHECK(mutex_lock(&pi_mutex, WAIT_FOREVER) == 0);
+
+    /* The high task preempts, blocks on the mutex and lends its priority */
+    task_create(pi_high, NULL, TEST_STACK_SIZE, TASK_PRIORITY_HIGH);
+    CHECK(low_tcb->priority == TASK_PRIORITY_HIGH);
+
+    /* Runs only after the mutex is handed over */
+    task_create(pi_medium, NULL, TEST_STACK_SIZE, TASK_PRIORITY_MEDIUM);
+    CHECK(!medium_ran_before_high);
+
+    low_done = 1;
+    CHECK(mutex_unlock(&pi_mutex) == 0);
+
+    CHECK(low_tcb->priority == TASK_PRIORITY_LOW);
+    CHECK(high_got_mutex);
+}
+
+static void pi_main(void *arg){
+    (void)arg;
+
+    mutex_init(&pi_mutex);
+    low_tcb = task_from_handle(task_create(pi_low, NULL, TEST_STACK_SIZE, TASK_PRIORITY_LOW));
+    CHECK(low_tcb != NULL);
+
+    task_delay(20);
+
+    CHECK(high_got_mutex);
+    CHECK(!medium_ran_before_high);
+    CHECK(mutex_trylock(&pi_mutex) == 0);
+
+    test_pass("mutex_pi");
+}
+
+
+/* ------------------------------------------------------------
+ * delete: delayed, object-blocked and ring-blocked tasks and a mutex
+ * owner are removed cleanly; stale handles fail; a returning task exits
+ * ------------------------------------------------------------ */
+
+static semaphore_t del_sem;
+static mutex_t del_mutex;
+static ring_buffer_t del_ring;
+static uint8_t del_ring_storage[16];
+static volatile int del_resurrected = 0;
+static volatile int del_waiter_got_mutex = 0;
+
+static void del_sleeper(void *arg){
+    (void)arg;
+
+    task_delay(100000U);
+    del_resurrected = 1;
+}
+
+static void del_sem_waiter(void *arg){
+    (void)arg;
+
+    sem_take(&del_sem, WAIT_FOREVER);
+    del_resurrected = 1;
+}
+
+static void del_ring_reader(void *arg){
+    uint8_t byte;
+
+    (void)arg;
+
+    ring_read(&del_ring, &byte, 1, WAIT_FOREVER);
+    del_resurrected = 1;
+}
+
+static void del_owner(void *arg){
+    (void)arg;
+
+    mutex_lock(&del_mutex, WAIT_FOREVER);
+    while(1){
+        task_delay(100);
+    }
+}
+
+static void del_mutex_waiter(void *arg){
+    (void)arg;
+
+    if (mutex_lock(&del_mutex, WAIT_FOREVER) == 0){
+        del_waiter_got_mutex = 1;
+        mutex_unlock(&del_mutex);
+    }
+}
+
+static void del_returner(void *arg){
+    (void)arg;
+}
+
+static void delete_main(void *arg){
+    (void)arg;
+
+    sem_init(&del_sem, 0, 1);
+    mutex_init(&del_mutex);
+    ring_init(&del_ring, del_ring_storage, sizeof(del_ring_storage));
+
+    task_handle_t victims[] = {
+        task_create(del_sleeper, NULL, TEST_STACK_SIZE, TASK_PRIORITY_MEDIUM),
+        task_create(del_sem_waiter, NULL, TEST_STACK_SIZE, TASK_PRIORITY_MEDIUM),
+        task_create(del_ring_reader, NULL, TEST_STACK_SIZE, TASK_PRIORITY_MEDIUM),
+    };
+    task_delay(2);
+
+    for (uint32_t i = 0; i < sizeof(victims) / sizeof(victims[0]); i++){
+        TCB_t *tcb = task_from_handle(victims[i]);
+
+        CHECK(tcb != NULL);
+        CHECK(task_delete(victims[i]) == 0);
+        CHECK(tcb->state == TASK_STATE_UNUSED);
+        CHECK(task_from_handle(victims[i]) == NULL);
+        CHECK(task_delete(victims[i]) == -1);
+    }
+
+    /* Nothing may wake the deleted waiters */
+    sem_give(&del_sem);
+    ring_push(&del_ring, 1);
+    task_delay(2);
+    CHECK(!del_resurrected);
+    for (uint32_t i = 0; i < sizeof(victims) / sizeof(victims[0]); i++){
+        CHECK(tcb_pool[victims[i] & 0xFFFF].state == TASK_STATE_UNUSED);
+    }
+
+    /* Deleting a mutex owner hands the mutex to its waiter */
+    task_handle_t owner = task_create(del_owner, NULL, TEST_STACK_SIZE, TASK_PRIORITY_MEDIUM);
+    task_delay(2);
+    task_create(del_mutex_waiter, NULL, TEST_STACK_SIZE, TASK_PRIORITY_MEDIUM);
+    task_delay(2);
+    CHECK(!del_waiter_got_mutex);
+    CHECK(task_delete(owner) == 0);
+    task_delay(2);
+    CHECK(del_waiter_got_mutex);
+
+    /* A task function that returns exits, and its slot is reused */
+    task_handle_t returner = task_create(del_returner, NULL, TEST_STACK_SIZE, TASK_PRIORITY_MEDIUM);
+    task_delay(2);
+    CHECK(task_from_handle(returner) == NULL);
+
+    /* The idle task cannot be deleted */
+    CHECK(task_delete(task_handle_of(&tcb_pool[0])) == -1);
+
+    test_pass("delete");
+}
+
+
+/* ------------------------------------------------------------ */
+
+static const struct {
+    const char *name;
+    void (*main_task)(void *);
+} scenarios[] = {
+    { "delay",    delay_main },
+    { "mutex_pi", pi_main },
+    { "delete",   delete_main },
+};
+
+
+int main(int argc, char **argv){
+    void (*main_task)(void *) = NULL;
+
+    for (uint32_t i = 0; argc > 1 && i < sizeof(scenarios) / sizeof(scenarios[0]); i++){
+        if (strcmp(argv[1], scenarios[i].name) == 0){
+            main_task = scenarios[i].main_task;
+        }
+    }
+    if (!main_task){
+        fprintf(stderr, "usage: %s delay|mutex_pi|delete\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    task_init();
+    task_create_idle(idle_task, NULL, 256);
+    task_create(main_task, NULL, TEST_STACK_SIZE, TASK_PRIORITY_HIGH);
+
+    init_systick_timer(TICK_HZ);
+    scheduler_start();
+
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""
+Decoder for the deferred LOG() records (Inc/log.h).
+
+The firmware sends each record as 32-bit words on ITM stimulus port 1:
+
+    0xA0 | nargs (top byte), format string ID (low 24 bits)
+    timestamp (ticks)
+    nargs arguments
+
+The ID is the offset of the format string in the ELF's .logstr section,
+which is not loaded on the target. This script reads .logstr from the
+ELF, parses a raw ITM/SWO capture and prints the records as text. Text
+on stimulus port 0 (printf) is passed through.
+
+Capture with OpenOCD, for example (168 MHz core clock):
+    monitor tpiu config internal swo.bin uart off 168000000
+    monitor itm port 0 on
+    monitor itm port 1 on
+
+Usage:
+    Tools/log_decode.py task-scheduler.elf swo.bin
+"""
+
+import re
+import struct
+import sys
+
+LOG_PORT = 1
+TEXT_PORT = 0
+MAX_ARGS = 4
+
+CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diouxXc%])")
+
+
+def read_logstr(elf_path):
+    """Return the contents of the .logstr section of a 32-bit ELF."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+
+    if elf[:4] != b"\x7fELF" or elf[4] != 1:
+        raise ValueError(f"{elf_path}: not a 32-bit ELF file")
+
+    e_shoff, = struct.unpack_from("<I", elf, 0x20)
+    e_shentsize, e_shnum, e_shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+
+    def section(index):
+        # name, type, flags, addr, offset, size
+        return struct.unpack_from("<IIIIII", elf, e_shoff + index * e_shentsize)
+
+    names_off = section(e_shstrndx)[4]
+    for i in range(e_shnum):
+        name, _, _, _, offset, size = section(i)
+        end = elf.index(b"\0", names_off + name)
+        if elf[names_off + name:end] == b".logstr":
+            return elf[offset:offset + size]
+
+    raise ValueError(f"{elf_path}: no .logstr section (no LOG() calls?)")
+
+
+def format_record(logstr, fmt_id, args):
+    """printf-style formatting of a record, arguments as uint32."""
+    if fmt_id >= len(logstr):
+        return f"<unknown format id 0x{fmt_id:06x}> {args}"
+
+    fmt = logstr[fmt_id:logstr.index(b"\0", fmt_id)].decode("utf-8", "replace")
+    values = iter(args)
+
+    def convert(m):
+        flags, _, conv = m.groups()
+        if conv == "%":
+            return "%"
+        value = next(values, 0)
+        if conv in "di" and value & 0x80000000:
+            value -= 1 << 32
+        if conv == "u":
+            conv = "d"
+        return ("%" + flags + conv) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def itm_packets(data):
+    """Yield (port, payload bytes) for every software source (SWIT) packet."""
+    i = 0
+    while i < len(data):
+        header = data[i]
+        i += 1
+
+        if header == 0x00 or header == 0x80 or header == 0x70:
+            continue                            # sync, sync end, overflow
+
+        size_bits = header & 0x03
+        if size_bits == 0:
+            # Timestamp or extension packet: continuation bit 7 per byte
+            if header & 0x80:
+                while i < len(data) and data[i] & 0x80:
+                    i += 1
+                i += 1
+            continue
+
+        size = {1: 1, 2: 2, 3: 4}[size_bits]
+        payload = data[i:i + size]
+        i += size
+
+        if header & 0x04:
+            continue                            # hardware source (DWT)
+        yield header >> 3, payload
+
+
+def decode(logstr, data, out):
+    words = []
+    text = bytearray()
+
+    for port, payload in itm_packets(data):
+        if port == TEXT_PORT:
+            text += payload
+            while b"\n" in text:
+                line, _, text = text.partition(b"\n")
+                out.write(line.decode("utf-8", "replace") + "\n")
+            continue
+
+        if port != LOG_PORT or len(payload) != 4:
+            continue
+        words.append(struct.unpack("<I", payload)[0])
+
+        # Resynchronise on a header word if the capture starts mid-record
+        while words and not ((words[0] >> 28) == 0xA and ((words[0] >> 24) & 0x0F) <= MAX_ARGS):
+            words.pop(0)
+        if len(words) < 2:
+            continue
+
+        nargs = (words[0] >> 24) & 0x0F
+        if len(words) < 2 + nargs:
+            continue
+
+        fmt_id = words[0] & 0x00FFFFFF
+        out.write(f"{words[1]:8d} {format_record(logstr, fmt_id, words[2:2 + nargs])}\n")
+        del words[:2 + nargs]
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write(__doc__)
+        return 2
+
+    logstr = read_logstr(argv[1])
+    with open(argv[2], "rb") as f:
+        decode(logstr, f.read(), sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""
+Convert a scheduler trace dump (Inc/trace.h) into Chrome trace JSON.
+
+Build with -DKERNEL_TRACE=ON, run, then dump the buffer from the
+debugger:
+
+    (gdb) dump binary value trace.bin trace_buffer
+
+and convert it:
+
+    Tools/trace_export.py trace.bin trace.json
+
+Open trace.json in https://ui.perfetto.dev or chrome://tracing. Every
+task is a thread of the "Tasks" process with a slice for each time it
+ran; ready, block, create and delete events are instants on its track.
+Interrupt handlers are threads of the "Interrupts" process.
+"""
+
+import json
+import struct
+import sys
+
+TRACE_MAGIC = 0x45435254
+HEADER = struct.Struct("<IIII")         # magic, counter_hz, capacity, head
+EVENT = struct.Struct("<IBBH")          # timestamp, type, arg, id
+
+SWITCH_IN, SWITCH_OUT, READY, BLOCK, CREATE, DELETE, ISR_ENTER, ISR_EXIT = range(1, 9)
+
+TASK_STATES = {0: "unused", 1: "ready", 2: "delayed", 3: "blocked", 4: "running"}
+BLOCK_REASONS = {0: "delay", 1: "object", 2: "signal"}
+EXCEPTIONS = {2: "NMI", 3: "HardFault", 4: "MemManage", 5: "BusFault",
+              6: "UsageFault", 11: "SVCall", 14: "PendSV", 15: "SysTick"}
+
+TASKS_PID = 1
+IRQ_PID = 2
+
+
+def read_events(data):
+    """Return (counter_hz, events oldest first) from a trace_buffer dump."""
+    magic, counter_hz, capacity, head = HEADER.unpack_from(data, 0)
+    if magic != TRACE_MAGIC:
+        raise ValueError("not a trace_buffer dump (bad magic)")
+
+    count = min(head, capacity)
+    first = head - count
+    events = []
+    for n in range(first, head):
+        offset = HEADER.size + (n % capacity) * EVENT.size
+        events.append(EVENT.unpack_from(data, offset))
+
+    return counter_hz, events
+
+
+def task_name(slot):
+    return "idle" if slot == 0 else f"task {slot}"
+
+
+def irq_name(irq):
+    return EXCEPTIONS.get(irq, f"IRQ{irq - 16}" if irq >= 16 else f"exception {irq}")
+
+
+def unwrap(events):
+    """Return (ticks, event) pairs in time order with the 32-bit counter unwrapped.
+
+    Slots are claimed before the timestamp is read, so an interrupt that
+    nests inside trace_record() can store a later slot with an earlier
+    timestamp. The step between neighbours is therefore taken as a signed
+    32-bit delta, and the (stable) sort puts such pairs back in order.
+    """
+    ticks = 0
+    last = events[0][0] if events else 0
+    unwrapped = []
+    for event in events:
+        delta = (event[0] - last) & 0xFFFFFFFF
+        if delta >= 0x80000000:
+            delta -= 0x100000000
+        ticks += delta
+        last = event[0]
+        unwrapped.append((ticks, event))
+
+    unwrapped.sort(key=lambda pair: pair[0])
+    return unwrapped
+
+
+def to_chrome(counter_hz, events):
+    out = []
+    tasks, irqs = set(), set()
+    running = {}            # slot -> open slice
+    in_isr = {}             # irq -> open slice
+
+    for ticks, (_, kind, arg, ident) in unwrap(events):
+        ts = ticks * 1e6 / counter_hz   # microseconds
+
+        if kind in (ISR_ENTER, ISR_EXIT):
+            irqs.add(ident)
+            if kind == ISR_ENTER:
+                in_isr[ident] = True
+                out.append({"ph": "B", "pid": IRQ_PID, "tid": ident, "ts": ts, "name": irq_name(ident)})
+            elif in_isr.pop(ident, False):
+                out.append({"ph": "E", "pid": IRQ_PID, "tid": ident, "ts": ts})
+            continue
+
+        tasks.add(ident)
+        base = {"pid": TASKS_PID, "tid": ident, "ts": ts}
+
+        if kind == SWITCH_IN:
+            running[ident] = True
+            out.append(dict(base, ph="B", name=task_name(ident)))
+        elif kind == SWITCH_OUT:
+            # The dump may start while the task was already running
+            if running.pop(ident, False):
+                out.append(dict(base, ph="E", args={"state": TASK_STATES.get(arg, arg)}))
+        elif kind == READY:
+            out.append(dict(base, ph="i", s="t", name="ready"))
+        elif kind == BLOCK:
+            out.append(dict(base, ph="i", s="t", name="block",
+                            args={"reason": BLOCK_REASONS.get(arg, arg)}))
+        elif kind == CREATE:
+            out.append(dict(base, ph="i", s="t", name="create", args={"priority": arg}))
+        elif kind == DELETE:
+            out.append(dict(base, ph="i", s="t", name="delete"))
+
+    meta = [{"ph": "M", "pid": TASKS_PID, "name": "process_name", "args": {"name": "Tasks"}},
+            {"ph": "M", "pid": IRQ_PID, "name": "process_name", "args": {"name": "Interrupts"}}]
+    for slot in sorted(tasks):
+        meta.append({"ph": "M", "pid": TASKS_PID, "tid": slot, "name": "thread_name",
+                     "args": {"name": task_name(slot)}})
+    for irq in sorted(irqs):
+        meta.append({"ph": "M", "pid": IRQ_PID, "tid": irq, "name": "thread_name",
+                     "args": {"name": irq_name(irq)}})
+
+    return {"traceEvents": meta + out, "displayTimeUnit": "ns"}
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write(__doc__)
+        return 2
+
+    with open(argv[1], "rb") as f:
+        counter_hz, events = read_events(f.read())
+
+    with open(argv[2], "w") as f:
+        json.dump(to_chrome(counter_hz, events), f)
+
+    print(f"{len(events)} events, {argv[2]}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))